@@ -692,6 +692,38 @@ class DiGraphSet(object):
             except StopIteration:
                 return
 
+    def sample(self, n, replace=True):
+        """Returns graphs drawn uniformly randomly.
+
+        The graphs are drawn independently if `replace` is True, or
+        distinct otherwise.  Each graph is drawn in time proportional to
+        the number of edges in the universe, so this method is much
+        faster than rand_iter() for many graphs.  This method relies on
+        its own random number generator like rand_iter().
+
+        Examples:
+          >>> graph1 = [(1, 2)]
+          >>> graph2 = [(1, 2), (1, 4)]
+          >>> gs = DiGraphSet([graph1, graph2])
+          >>> gs.sample(2, replace=False)
+          [[(1, 2), (1, 4)], [(1, 2)]]
+
+        Args:
+          n: The number of graphs.
+          replace: Optional.  True if a graph may be drawn repeatedly.
+
+        Returns:
+          A list of graphs.
+
+        Raises:
+          ValueError: If `self` is empty, or if `replace` is False and
+            `self` has less than `n` graphs.
+
+        See Also:
+          rand_iter()
+        """
+        return [DiGraphSet._conv_ret(g) for g in self._ss.sample(n, replace)]
+
     def min_iter(self, weights=None):
         """Iterates over graphs in the ascending order of weights.
 
@@ -1142,11 +1174,37 @@ class DiGraphSet(object):
           A new DiGraphSet object.
 
         See Also:
-          smaller(), larger()
+          smaller(), larger(), size_histogram()
 
         """
         return DiGraphSet(self._ss.set_size(size))
 
+    def size_histogram(self):
+        """Returns the number of graphs for each number of edges.
+
+        The histogram is computed in one pass over the diagram, instead
+        of calling `len(gs.graph_size(k))` for every `k`.
+
+        Examples:
+          >>> graph1 = [(1, 2)]
+          >>> graph2 = [(1, 2), (1, 4)]
+          >>> graph3 = [(1, 2), (1, 4), (2, 3)]
+          >>> gs = DiGraphSet([graph1, graph2, graph3])
+          >>> gs.size_histogram()
+          {1: 1, 2: 1, 3: 1}
+
+        Returns:
+          A dictionary mapping a number of edges to the number of
+          graphs with that many edges.  Sizes without graphs are
+          omitted.
+
+        See Also:
+          graph_size(), len()
+
+        """
+        counts = self._ss.size_histogram()
+        return dict((k, c) for k, c in enumerate(counts) if c > 0)
+
     def complement(self):
         """Returns a new DiGraphSet with complement graphs of `self`.
 
@@ -1490,6 +1548,37 @@ class DiGraphSet(object):
         """
         return self._ss.probability(probabilities)
 
+    def probabilities(self, probabilities_list):
+        """Returns the probabilities of `self` for many edge probabilities.
+
+        This method is equivalent to calling `probability()` for each
+        item of `probabilities_list`, but the diagram is traversed once
+        for all of them, which is much faster for many scenarios.
+
+        Examples:
+          >>> graph1 = [(1, 2), (1, 4)]
+          >>> graph2 = [(2, 3)]
+          >>> gs = DiGraphSet([graph1, graph2])
+          >>> probabilities1 = {(1, 2): .9, (1, 4): .8, (2, 3): .7}
+          >>> probabilities2 = {(1, 2): .5, (1, 4): .5, (2, 3): .5}
+          >>> gs.probabilities([probabilities1, probabilities2])
+          [0.23, 0.25]
+
+        Args:
+          probabilities_list: A list of dictionaries of probabilities
+            of each edge.
+
+        Returns:
+          A list of probabilities in the same order.
+
+        Raises:
+          KeyError: If a given edge is not found in the universe.
+
+        See Also:
+          probability()
+        """
+        return self._ss.probabilities(probabilities_list)
+
     def dump(self, fp):
         """Serialize `self` to a file `fp`.
 
@@ -1586,11 +1675,15 @@ class DiGraphSet(object):
             The default is 'greedy', best-first search from `source`
             with respect to the number of unused incident edges.
             Other options include 'bfs', the breadth-first search, 
-            'dfs', the depth-first search, and 'as-is', the order of
+            'dfs', the depth-first search, 'frontier', the native
+            ordering that minimizes the maximum and the total frontier
+            sizes (see frontier_widths()), and 'as-is', the order of
             `universe` list.
 
           source: Optional.  This argument specifies the starting
-            point of the edge traversal.
+            point of the edge traversal.  If not specified, 'frontier'
+            tries several peripheral vertices and the others start from
+            the minimum vertex.
 
         See Also:
           universe()
@@ -1607,7 +1700,9 @@ class DiGraphSet(object):
             indexed_edges.add(e[:2])
             if len(e) > 2:
                 DiGraphSet._weights[e[:2]] = e[2]
-        if traversal != 'as-is':
+        if traversal == 'frontier':
+            sorted_edges = DiGraphSet._order_by_frontier(sorted_edges, source)
+        elif traversal != 'as-is':
             if source is None:
                 source = sorted_edges[0][0]
                 for e in sorted_edges:
@@ -1618,6 +1713,7 @@ class DiGraphSet(object):
             DiGraphSet._vertices.add(u)
             DiGraphSet._vertices.add(v)
         setset.set_universe(sorted_edges)
+        DiGraphSet._graph_handle = None
 
     @staticmethod
     def universe():
@@ -1644,6 +1740,33 @@ class DiGraphSet(object):
                 edges.append(e)
         return DiGraphSet.converters['to_graph'](edges)
 
+    @staticmethod
+    def frontier_widths():
+        """Returns the frontier sizes of the current edge order.
+
+        The frontier is the set of vertices incident to both processed
+        and unprocessed edges, which bounds the size of the internal
+        states of the searches such as directed_cycles().  The widths
+        depend on the edge order given by `traversal` of
+        set_universe().
+
+        Examples:
+          >>> DiGraphSet.set_universe(universe, traversal='frontier')
+          >>> DiGraphSet.frontier_widths()
+          (4, 52)
+
+        Returns:
+          A tuple of the maximum frontier size and the sum of the
+          frontier sizes over all the edges.
+
+        See Also:
+          set_universe()
+        """
+        vertex_index, indexed_edges = DiGraphSet._index_vertices(
+            setset.universe())
+        return _digraphillion._frontier_widths(
+            len(vertex_index), indexed_edges)
+
     @staticmethod
     def directed_cycles(graphset=None):
         """Returns a DiGraphSet with directed single cycles.
@@ -1659,16 +1782,17 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+        search, kwargs = DiGraphSet._directed_cycles_args(graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _directed_cycles_args(graphset=None):
+        graph = DiGraphSet._universe_graph()
 
         ss = None if graphset is None else graphset._ss
 
-        ss = _digraphillion._directed_cycles(graph=graph, search_space=ss)
-        return DiGraphSet(ss)
+        return _digraphillion._directed_cycles, dict(
+            graph=graph, search_space=ss)
 
     @staticmethod
     def directed_hamiltonian_cycles(graphset=None):
@@ -1685,17 +1809,18 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+        search, kwargs = DiGraphSet._directed_hamiltonian_cycles_args(
+            graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _directed_hamiltonian_cycles_args(graphset=None):
+        graph = DiGraphSet._universe_graph()
 
         ss = None if graphset is None else graphset._ss
 
-        ss = _digraphillion._directed_hamiltonian_cycles(
+        return _digraphillion._directed_hamiltonian_cycles, dict(
             graph=graph, search_space=ss)
-        return DiGraphSet(ss)
 
     @staticmethod
     def directed_st_paths(s, t, is_hamiltonian=False, graphset=None):
@@ -1722,20 +1847,21 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+        search, kwargs = DiGraphSet._directed_st_paths_args(
+            s, t, is_hamiltonian, graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _directed_st_paths_args(s, t, is_hamiltonian=False, graphset=None):
+        graph = DiGraphSet._universe_graph()
 
         ss = None if graphset is None else graphset._ss
 
         assert(s in DiGraphSet._vertices and t in DiGraphSet._vertices)
 
-        ss = _digraphillion._directed_st_path(
+        return _digraphillion._directed_st_path, dict(
             graph=graph, s=pickle.dumps(s, protocol=0), t=pickle.dumps(t, protocol=0),
             is_hamiltonian=is_hamiltonian, search_space=ss)
-        return DiGraphSet(ss)
 
     @staticmethod
     def rooted_forests(roots=None, is_spanning=False, graphset=None):
@@ -1758,11 +1884,13 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+        search, kwargs = DiGraphSet._rooted_forests_args(
+            roots, is_spanning, graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _rooted_forests_args(roots=None, is_spanning=False, graphset=None):
+        graph = DiGraphSet._universe_graph()
 
         rs = []
         if roots is not None:
@@ -1772,9 +1900,8 @@ class DiGraphSet(object):
 
         ss = None if graphset is None else graphset._ss
 
-        ss = _digraphillion._rooted_forests(
+        return _digraphillion._rooted_forests, dict(
             graph=graph, roots=rs, is_spanning=is_spanning, search_space=ss)
-        return DiGraphSet(ss)
 
     @staticmethod
     def rooted_trees(root, is_spanning=False, graphset=None):
@@ -1799,17 +1926,19 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+        search, kwargs = DiGraphSet._rooted_trees_args(
+            root, is_spanning, graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _rooted_trees_args(root, is_spanning=False, graphset=None):
+        graph = DiGraphSet._universe_graph()
 
         ss = None if graphset is None else graphset._ss
 
-        ss = _digraphillion._rooted_trees(
-            graph=graph, root=pickle.dumps(root, protocol=0), is_spanning=is_spanning, search_space=ss)
-        return DiGraphSet(ss)
+        return _digraphillion._rooted_trees, dict(
+            graph=graph, root=pickle.dumps(root, protocol=0),
+            is_spanning=is_spanning, search_space=ss)
 
     @staticmethod
     def graphs(in_degree_constraints=None, out_degree_constraints=None, graphset=None):
@@ -1838,45 +1967,183 @@ class DiGraphSet(object):
           Returns:
             A new DiGraphSet object.
         """
-        graph = []
-        for e in setset.universe():
-            assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
-            graph.append(
-                (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
-
-        in_dc = None
-        if in_degree_constraints is not None:
-            in_dc = {}
-            for v, r in viewitems(in_degree_constraints):
-                if v not in DiGraphSet._vertices:
-                    raise KeyError(v)
-                if isinstance(r, int):
-                    in_dc[pickle.dumps(v, protocol=0)] = (r, r + 1, 1)
-                elif len(r) == 1:
-                    in_dc[pickle.dumps(v, protocol=0)] = (r[0], r[0] + 1, 1)
-                else:
-                    in_dc[pickle.dumps(v, protocol=0)] = (
-                        r[0], r[-1] + 1, r[1] - r[0])
-
-        out_dc = None
-        if out_degree_constraints is not None:
-            out_dc = {}
-            for v, r in viewitems(out_degree_constraints):
-                if v not in DiGraphSet._vertices:
-                    raise KeyError(v)
-                if isinstance(r, int):
-                    out_dc[pickle.dumps(v, protocol=0)] = (r, r + 1, 1)
-                elif len(r) == 1:
-                    out_dc[pickle.dumps(v, protocol=0)] = (r[0], r[0] + 1, 1)
-                else:
-                    out_dc[pickle.dumps(v, protocol=0)] = (
-                        r[0], r[-1] + 1, r[1] - r[0])
+        search, kwargs = DiGraphSet._graphs_args(
+            in_degree_constraints, out_degree_constraints, graphset)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _graphs_args(in_degree_constraints=None, out_degree_constraints=None,
+                     graphset=None):
+        graph = DiGraphSet._universe_graph()
+
+        in_dc = DiGraphSet._conv_degree_constraints(in_degree_constraints)
+        out_dc = DiGraphSet._conv_degree_constraints(out_degree_constraints)
 
         ss = None if graphset is None else graphset._ss
 
-        ss = _digraphillion._directed_graphs(
-            graph=graph, in_degree_constraints=in_dc, out_degree_constraints=out_dc, search_space=ss)
-        return DiGraphSet(ss)
+        return _digraphillion._directed_graphs, dict(
+            graph=graph, in_degree_constraints=in_dc,
+            out_degree_constraints=out_dc, search_space=ss)
+
+    @staticmethod
+    def search(structure=None, in_degree_constraints=None,
+               out_degree_constraints=None, num_edges=None, graphset=None,
+               **kwargs):
+        """Returns a DiGraphSet with subgraphs satisfying all the constraints.
+
+        The structure given by the name of a search method is combined
+        with the degree constraints of graphs() and the number of
+        edges, and they are checked at once in a single search.  It is
+        equivalent to the intersection of the DiGraphSets given by each
+        constraint, but much faster since they are never built.
+
+        Examples:
+          >>> DiGraphSet.search('rooted_trees', root=1, num_edges=range(3))
+          DiGraphSet([[], [(1, 4)], [(1, 2)], [(1, 4), (4, 5)], [(1, 2), (1, 4)],  ...
+
+          >>> DiGraphSet.search('directed_cycles',
+          ...                   in_degree_constraints={1: 1})
+          DiGraphSet([[(1, 4), (4, 1)], [(1, 2), (2, 1)], [(1, 2), (2, 5), ( ...
+
+        Args:
+          structure: Optional.  The name of a search method, i.e., one
+            of 'directed_cycles', 'directed_hamiltonian_cycles',
+            'directed_st_paths', 'rooted_forests', and 'rooted_trees'.
+            If not specified, subgraphs are not restricted in structure.
+
+          in_degree_constraints, out_degree_constraints: Optional.  The
+            degree constraints as graphs().
+
+          num_edges: Optional.  An int or range.  The number of edges in
+            subgraphs is restricted by it.
+
+          graphset: Optional.  A DiGraphSet object.  Components to be
+            stored are selected from this object.
+
+          kwargs: The arguments of the search method given by
+            `structure`, i.e., `s`, `t`, and `is_hamiltonian` for
+            'directed_st_paths', `roots` and `is_spanning` for
+            'rooted_forests', and `root` and `is_spanning` for
+            'rooted_trees'.
+
+        Returns:
+          A new DiGraphSet object.
+
+        Raises:
+          ValueError: If `structure` is not a search method.
+          TypeError: If `kwargs` are not the arguments of it.
+
+        See Also:
+          graphs()
+        """
+        search, kwargs = DiGraphSet._search_args(
+            structure, in_degree_constraints, out_degree_constraints,
+            num_edges, graphset, **kwargs)
+        return DiGraphSet(search(**kwargs))
+
+    @staticmethod
+    def _search_args(structure=None, in_degree_constraints=None,
+                     out_degree_constraints=None, num_edges=None,
+                     graphset=None, **kwargs):
+        args = {
+            None: (),
+            'directed_cycles': (),
+            'directed_hamiltonian_cycles': (),
+            'directed_st_paths': ('s', 't', 'is_hamiltonian'),
+            'rooted_forests': ('roots', 'is_spanning'),
+            'rooted_trees': ('root', 'is_spanning'),
+        }
+        if structure not in args:
+            raise ValueError('not a search method: %s' % structure)
+        for key in kwargs:
+            if key not in args[structure]:
+                raise TypeError('unexpected argument: %s' % key)
+
+        graph = DiGraphSet._universe_graph()
+
+        for key in ('s', 't', 'root'):
+            if key in kwargs:
+                assert kwargs[key] in DiGraphSet._vertices
+                kwargs[key] = pickle.dumps(kwargs[key], protocol=0)
+        if kwargs.get('roots') is not None:
+            rs = []
+            for root in kwargs['roots']:
+                assert root in DiGraphSet._vertices
+                rs.append(pickle.dumps(root, protocol=0))
+            kwargs['roots'] = rs
+
+        in_dc = DiGraphSet._conv_degree_constraints(in_degree_constraints)
+        out_dc = DiGraphSet._conv_degree_constraints(out_degree_constraints)
+        ne = None if num_edges is None else DiGraphSet._conv_range(num_edges)
+
+        ss = None if graphset is None else graphset._ss
+
+        kwargs.update(
+            graph=graph, structure=structure, in_degree_constraints=in_dc,
+            out_degree_constraints=out_dc, num_edges=ne, search_space=ss)
+        return _digraphillion._directed_subgraphs, kwargs
+
+    @staticmethod
+    def estimate(method, *args, **kwargs):
+        """Estimates the cost of a search without building the DiGraphSet.
+
+        The search given by `method` is simulated level by level, keeping
+        at most `width_limit` internal states at each level; if a level
+        has more states, a random sample of them is expanded and the
+        number of the nodes is extrapolated.  The estimate is exact if
+        no level exceeds `width_limit`, and otherwise it tends to be on
+        the low side; `state_bound` gives a safe upper bound.
+
+        Examples:
+          >>> e = DiGraphSet.estimate('directed_hamiltonian_cycles')
+          >>> e['exact'], e['nodes']
+          (True, 54.0)
+          >>> e = DiGraphSet.estimate('directed_st_paths', 1, 6,
+          ...                         width_limit=1000)
+
+        Args:
+          method: The name of a search method, i.e., one of
+            'directed_cycles', 'directed_hamiltonian_cycles',
+            'directed_st_paths', 'rooted_forests', 'rooted_trees',
+            'graphs', and 'search'.
+
+          args, kwargs: The arguments passed to the search method.
+
+          width_limit: Optional.  A positive integer, the maximum
+            number of the states expanded at each level.  The default
+            is 10000.
+
+        Returns:
+          A dict with the following keys:
+            'frontier_sizes', 'max_frontier_size': the number of the
+              vertices on the frontier for each edge and its maximum.
+            'state_bounds', 'state_bound': upper bounds of the number
+              of the states for each edge and their sum, which do not
+              take `graphset` into account.
+            'node_counts', 'nodes': the estimated number of the nodes
+              created for each edge and their sum.
+            'seconds', 'memory': the estimated time in seconds and
+              memory in bytes of the search.
+            'width_limit', 'exact': the width limit given, and True if
+              no state was dropped.
+
+        Raises:
+          ValueError: If `method` is not a search method.
+
+        See Also:
+          frontier_widths()
+        """
+        methods = ('directed_cycles', 'directed_hamiltonian_cycles',
+                   'directed_st_paths', 'rooted_forests', 'rooted_trees',
+                   'graphs', 'search')
+        if method not in methods:
+            raise ValueError('not a search method: %s' % method)
+        width_limit = kwargs.pop('width_limit', 10000)
+        # The search is given the same arguments as the method, but it
+        # only runs the estimator, which returns a dict.
+        search, kwargs = getattr(DiGraphSet, '_%s_args' % method)(
+            *args, **kwargs)
+        return search(estimate=width_limit, **kwargs)
 
     @staticmethod
     def show_messages(flag=True):
@@ -1892,6 +2159,94 @@ class DiGraphSet(object):
         """
         return _digraphillion._show_messages(flag)
 
+    @staticmethod
+    def set_num_threads(num_threads=None):
+        """Sets the number of threads used to build DiGraphSets.
+
+        The number of threads affects directed_cycles(),
+        directed_hamiltonian_cycles(), directed_st_paths(),
+        rooted_forests(), rooted_trees(), graphs(), search(), and the
+        counting of graphs such as len().  The OpenMP setting of the
+        process is left unchanged.
+
+        Examples:
+          >>> DiGraphSet.set_num_threads(8)
+          1
+          >>> cycles = DiGraphSet.directed_hamiltonian_cycles()
+
+        Args:
+          num_threads: Optional.  A positive integer.  If not
+            specified, the current setting is kept.  A single thread is
+            always used if the module is built without OpenMP.
+
+        Returns:
+          The setting before the method call.
+
+        Raises:
+          ValueError: If `num_threads` is not positive.
+        """
+        if num_threads is None:
+            return _digraphillion._num_threads()
+        return _digraphillion._num_threads(num_threads)
+
+    @staticmethod
+    def _universe_graph():
+        # The universe is parsed into a digraph on the C++ side only once,
+        # at the first search, and the searches refer to it by the handle.
+        if DiGraphSet._graph_handle is None:
+            graph = []
+            for e in setset.universe():
+                assert e[0] in DiGraphSet._vertices and e[1] in DiGraphSet._vertices
+                graph.append(
+                    (pickle.dumps(e[0], protocol=0), pickle.dumps(e[1], protocol=0)))
+            DiGraphSet._graph_handle = \
+                _digraphillion._register_universe_graph(graph)
+        return DiGraphSet._graph_handle
+
+    @staticmethod
+    def _conv_range(r):
+        # An int or range is passed to the C++ side as (min, max, step).
+        if isinstance(r, int):
+            return (r, r + 1, 1)
+        elif len(r) == 1:
+            return (r[0], r[0] + 1, 1)
+        else:
+            return (r[0], r[-1] + 1, r[1] - r[0])
+
+    @staticmethod
+    def _conv_degree_constraints(constraints):
+        if constraints is None:
+            return None
+        dc = {}
+        for v, r in viewitems(constraints):
+            if v not in DiGraphSet._vertices:
+                raise KeyError(v)
+            dc[pickle.dumps(v, protocol=0)] = DiGraphSet._conv_range(r)
+        return dc
+
+    @staticmethod
+    def _index_vertices(edges):
+        vertex_index = {}
+        indexed_edges = []
+        for u, v in edges:
+            for w in (u, v):
+                if w not in vertex_index:
+                    vertex_index[w] = len(vertex_index)
+            indexed_edges.append((vertex_index[u], vertex_index[v]))
+        return vertex_index, indexed_edges
+
+    @staticmethod
+    def _order_by_frontier(edges, source):
+        vertex_index, indexed_edges = DiGraphSet._index_vertices(edges)
+        if source is None:
+            source = -1
+        else:
+            assert source in vertex_index
+            source = vertex_index[source]
+        order = _digraphillion._order_edges(
+            len(vertex_index), indexed_edges, source)
+        return [edges[i] for i in order]
+
     @staticmethod
     def _traverse(indexed_edges, traversal, source):
         neighbors = {}
@@ -2013,3 +2368,4 @@ class DiGraphSet(object):
 
     _vertices = set()
     _weights = {}
+    _graph_handle = None
@@ -121,12 +121,17 @@ class setset(_digraphillion.setset):
         return _digraphillion.setset.flip(self, elem)
 
     def __iter__(self):
+        # The sets are taken in batches, which grow so that breaking out of
+        # the loop early does not enumerate many sets in vain.
         i = _digraphillion.setset.iter(self)
+        n = 1
         while (True):
-            try:
-                yield setset._conv_ret(next(i))
-            except StopIteration:
+            sets = i.next_n(n)
+            for s in sets:
+                yield setset._conv_ret(s)
+            if len(sets) < n:
                 return
+            n = min(n * 2, setset._max_iter_batch)
 
     def rand_iter(self):
         i = _digraphillion.setset.rand_iter(self)
@@ -136,6 +141,12 @@ class setset(_digraphillion.setset):
             except StopIteration:
                 return
 
+    def sample(self, n, replace=True):
+        sets = _digraphillion.setset.sample(self, n, replace)
+        if len(sets) < n:
+            raise ValueError('sample larger than population')
+        return [setset._conv_ret(s) for s in sets]
+
     def min_iter(self, weights=None, default=1):
         return self._optimize(weights, default, _digraphillion.setset.min_iter)
 
@@ -177,6 +188,17 @@ class setset(_digraphillion.setset):
         assert len([p for p in ps[1:] if p < 0 or 1 < p]) == 0
         return _digraphillion.setset.probability(self, ps)
 
+    def probabilities(self, probabilities_list):
+        pss = []
+        for probabilities in probabilities_list:
+            ps = [-1] * (_digraphillion._num_elems() + 1)
+            for e, p in viewitems(probabilities):
+                i = setset._obj2int[e]
+                ps[i] = p
+            assert len([p for p in ps[1:] if p < 0 or 1 < p]) == 0
+            pss.append(ps)
+        return _digraphillion.setset.probabilities(self, pss)
+
     @staticmethod
     def load(fp):
         return _digraphillion.load(fp)
@@ -248,3 +270,4 @@ class setset(_digraphillion.setset):
 
     _obj2int = {}
     _int2obj = [None]
+    _max_iter_batch = 1024
@@ -20,6 +20,12 @@
 
 import graphillion
 from digraphillion import DiGraphSet
+import _digraphillion
+import itertools
+import os
+import pickle
+import subprocess
+import sys
 import unittest
 from graphillion import GraphSet
 
@@ -104,6 +110,26 @@ class TestDigraphillion(unittest.TestCase):
         gs = DiGraphSet.directed_st_paths(s, t)
         self.assertEqual(len(gs), 1)
 
+    def test_directed_st_paths_one_way(self):
+        # Many fragments are cut off from t, which are pruned by the
+        # reachability through the unprocessed edges.
+        edges = [(1, 2), (2, 3), (3, 4), (5, 1), (2, 6), (6, 7), (7, 3),
+                 (4, 8), (8, 7), (6, 5), (3, 9), (9, 10), (10, 4), (8, 10)]
+        DiGraphSet.set_universe(edges)
+
+        def paths(v, t, visited):
+            if v == t:
+                return 1
+            return sum(paths(w, t, visited | set([w]))
+                       for u, w in edges if u == v and w not in visited)
+
+        for s in range(1, 11):
+            for t in range(1, 11):
+                if s == t:
+                    continue
+                gs = DiGraphSet.directed_st_paths(s, t)
+                self.assertEqual(len(gs), paths(s, t, set([s])))
+
     def test_directed_st_hamiltonian_paths(self):
         DiGraphSet.set_universe(universe_edges)
         s, t = 1, 6
@@ -307,6 +333,228 @@ class TestDigraphillion(unittest.TestCase):
 
         self.assertTrue(trees.issubset(gs))
 
+    def test_search(self):
+        DiGraphSet.set_universe(universe_edges)
+
+        all_graphs = DiGraphSet.graphs()
+        small = all_graphs.smaller(4)
+        in_dc = {1: 0, 5: range(1, 3)}
+        out_dc = {2: range(0, 2)}
+        degree = DiGraphSet.graphs(in_degree_constraints=in_dc,
+                                   out_degree_constraints=out_dc)
+
+        self.assertEqual(DiGraphSet.search(), all_graphs)
+        self.assertEqual(DiGraphSet.search(num_edges=range(4)), small)
+        self.assertEqual(DiGraphSet.search(num_edges=3), small - small.smaller(3))
+        self.assertEqual(
+            DiGraphSet.search(in_degree_constraints=in_dc,
+                              out_degree_constraints=out_dc),
+            degree)
+
+        for structure, kwargs in [
+                ('directed_cycles', {}),
+                ('directed_hamiltonian_cycles', {}),
+                ('directed_st_paths', {'s': 1, 't': 6}),
+                ('directed_st_paths', {'s': 4, 't': 3, 'is_hamiltonian': True}),
+                ('rooted_forests', {'roots': [2, 4]}),
+                ('rooted_trees', {'root': 1}),
+                ('rooted_trees', {'root': 5, 'is_spanning': True})]:
+            gs = getattr(DiGraphSet, structure)(**kwargs)
+            self.assertEqual(DiGraphSet.search(structure, **kwargs), gs)
+            self.assertEqual(
+                DiGraphSet.search(structure, num_edges=range(4), **kwargs),
+                gs & small)
+            self.assertEqual(
+                DiGraphSet.search(structure, in_dc, out_dc, range(4),
+                                  graphset=gs.including(4), **kwargs),
+                gs.including(4) & degree & small)
+
+        self.assertRaises(ValueError, DiGraphSet.search, 'graphs')
+        self.assertRaises(TypeError, DiGraphSet.search, 'directed_cycles',
+                          root=1)
+
+    def test_search_space(self):
+        # the elements of a larger universe are left below the current one
+        DiGraphSet.set_universe(universe_edges + [(6, 7), (7, 6)])
+        DiGraphSet.set_universe(universe_edges)
+
+        forests = DiGraphSet.rooted_forests()
+        for gs in [forests.including((1, 2)), forests.smaller(3),
+                   DiGraphSet(), DiGraphSet([[]])]:
+            self.assertEqual(DiGraphSet.directed_cycles(gs),
+                             DiGraphSet.directed_cycles() & gs)
+            self.assertEqual(DiGraphSet.rooted_trees(1, graphset=gs),
+                             DiGraphSet.rooted_trees(1) & gs)
+            self.assertEqual(DiGraphSet.graphs({2: 1}, None, gs),
+                             DiGraphSet.graphs({2: 1}) & gs)
+
+    def test_num_threads(self):
+        DiGraphSet.set_universe(universe_edges)
+        cycles = DiGraphSet.directed_cycles()
+        hamiltonian_cycles = DiGraphSet.directed_hamiltonian_cycles()
+        paths = DiGraphSet.directed_st_paths(1, 6)
+        forests = DiGraphSet.rooted_forests([1, 4])
+        trees = DiGraphSet.rooted_trees(1, True)
+        in_dc = {v: range(1, 2) for v in DiGraphSet._vertices}
+        graphs = DiGraphSet.graphs(in_degree_constraints=in_dc)
+
+        old = DiGraphSet.set_num_threads(2)
+        try:
+            self.assertEqual(DiGraphSet.set_num_threads(), 2)
+            self.assertEqual(DiGraphSet.directed_cycles(), cycles)
+            self.assertEqual(DiGraphSet.directed_hamiltonian_cycles(),
+                             hamiltonian_cycles)
+            self.assertEqual(DiGraphSet.directed_st_paths(1, 6), paths)
+            self.assertEqual(DiGraphSet.rooted_forests([1, 4]), forests)
+            self.assertEqual(DiGraphSet.rooted_trees(1, True), trees)
+            self.assertEqual(
+                DiGraphSet.graphs(in_degree_constraints=in_dc), graphs)
+            self.assertEqual(
+                DiGraphSet.directed_cycles(DiGraphSet.graphs()), cycles)
+        finally:
+            DiGraphSet.set_num_threads(old)
+
+        self.assertRaises(ValueError, DiGraphSet.set_num_threads, 0)
+        self.assertRaises(ValueError, DiGraphSet.set_num_threads, -1)
+        self.assertRaises((ValueError, OverflowError),
+                          DiGraphSet.set_num_threads, 2**31)
+        self.assertRaises(TypeError, DiGraphSet.set_num_threads, 1.5)
+        self.assertEqual(DiGraphSet.set_num_threads(), old)
+
+    def test_universe_graph(self):
+        DiGraphSet.set_universe(universe_edges)
+        cycles = DiGraphSet.directed_cycles()
+        handle = DiGraphSet._graph_handle
+        self.assertEqual(DiGraphSet.directed_cycles(), cycles)
+        self.assertEqual(DiGraphSet._graph_handle, handle)
+
+        DiGraphSet.set_universe([(1, 2), (2, 1)])
+        self.assertEqual(DiGraphSet.directed_cycles(),
+                         DiGraphSet([[(1, 2), (2, 1)]]))
+        self.assertNotEqual(DiGraphSet._graph_handle, handle)
+        self.assertRaises(ValueError, _digraphillion._directed_cycles,
+                          graph=handle)
+
+        # an edge list given to a search directly keeps the universe graph
+        DiGraphSet.set_universe(universe_edges)
+        cycles = DiGraphSet.directed_cycles()
+        handle = DiGraphSet._graph_handle
+        graph = [(pickle.dumps(u, protocol=0), pickle.dumps(v, protocol=0))
+                 for u, v in DiGraphSet.universe()]
+        ss = _digraphillion._directed_cycles(graph=graph)
+        self.assertEqual(DiGraphSet(ss), cycles)
+        self.assertEqual(DiGraphSet.directed_cycles(), cycles)
+        self.assertEqual(DiGraphSet._graph_handle, handle)
+        ss = _digraphillion._directed_st_path(
+            graph=graph, s=pickle.dumps(1, protocol=0),
+            t=pickle.dumps(6, protocol=0), is_hamiltonian=False)
+        self.assertEqual(DiGraphSet(ss), DiGraphSet.directed_st_paths(1, 6))
+        self.assertEqual(DiGraphSet._graph_handle, handle)
+
+    def test_frontier_traversal(self):
+        DiGraphSet.set_universe(universe_edges, traversal='as-is')
+        self.assertEqual(DiGraphSet.frontier_widths(), (6, 63))
+        cycles = set(frozenset(g) for g in DiGraphSet.directed_cycles())
+
+        DiGraphSet.set_universe(universe_edges, traversal='frontier')
+        self.assertEqual(set(DiGraphSet.universe()), set(universe_edges))
+        self.assertEqual(DiGraphSet.frontier_widths(), (3, 36))
+        self.assertEqual(
+            set(frozenset(g) for g in DiGraphSet.directed_cycles()), cycles)
+
+        DiGraphSet.set_universe(universe_edges, traversal='frontier',
+                                source=6)
+        self.assertEqual(set(DiGraphSet.universe()), set(universe_edges))
+        self.assertTrue(6 in DiGraphSet.universe()[0])
+
+    def test_one_way_spanning(self):
+        # Vertices starved of incoming or outgoing edges are pruned early.
+        edges = [(1, 2), (2, 3), (3, 1), (3, 4), (4, 5), (5, 3), (2, 6),
+                 (6, 4), (5, 6), (6, 1), (4, 2)]
+        DiGraphSet.set_universe(edges)
+        vertices = set(range(1, 7))
+
+        def reachable(g, v):
+            visited = set([v])
+            stack = [v]
+            while stack:
+                u = stack.pop()
+                for a, b in g:
+                    if a == u and b not in visited:
+                        visited.add(b)
+                        stack.append(b)
+            return visited
+
+        cycles = 0
+        trees = 0
+        for g in itertools.combinations(edges, len(vertices) - 1):
+            heads = [b for a, b in g]
+            if 1 not in heads and len(set(heads)) == len(heads) and \
+                    reachable(g, 1) == vertices:
+                trees += 1
+        for g in itertools.combinations(edges, len(vertices)):
+            if sorted(a for a, b in g) == sorted(vertices) and \
+                    sorted(b for a, b in g) == sorted(vertices) and \
+                    reachable(g, 1) == vertices:
+                cycles += 1
+
+        self.assertEqual(len(DiGraphSet.directed_hamiltonian_cycles()), cycles)
+        self.assertEqual(len(DiGraphSet.rooted_trees(1, True)), trees)
+        self.assertEqual(len(DiGraphSet.rooted_forests([1], True)), trees)
+
+    def test_estimate(self):
+        DiGraphSet.set_universe(universe_edges)
+        e = DiGraphSet.estimate('directed_hamiltonian_cycles')
+        self.assertTrue(e['exact'])
+        self.assertEqual(e['max_frontier_size'], 3)
+        self.assertEqual(len(e['frontier_sizes']), len(universe_edges))
+        self.assertEqual(len(e['node_counts']), len(universe_edges))
+        self.assertEqual(e['nodes'], sum(e['node_counts']))
+        self.assertTrue(e['nodes'] <= e['state_bound'])
+
+        e = DiGraphSet.estimate('directed_st_paths', 1, 6, width_limit=1)
+        self.assertFalse(e['exact'])
+        self.assertEqual(e['width_limit'], 1)
+
+        e = DiGraphSet.estimate('rooted_trees', 1,
+                                graphset=DiGraphSet.directed_cycles())
+        self.assertTrue(e['exact'])
+
+        self.assertRaises(ValueError, DiGraphSet.estimate, 'paths')
+        self.assertRaises(ValueError, DiGraphSet.estimate, 'directed_cycles',
+                          width_limit=0)
+        self.assertTrue(isinstance(DiGraphSet.directed_cycles(), DiGraphSet))
+
+    def test_out_of_nodes(self):
+        # The node table of SAPPOROBDD is reinitialized with a small limit
+        # in another process, so that the ZDD of the search overflows it.
+        script = """
+import ctypes
+import _digraphillion
+from digraphillion import DiGraphSet
+lib = ctypes.CDLL(_digraphillion.__file__)
+lib._ZN13digraphillion4initEv()
+lib.bddinit(ctypes.c_uint64(256), ctypes.c_uint64(300))
+n = 5
+edges = []
+for v in range(1, n * n + 1):
+    if v % n != 0:
+        edges += [(v, v + 1), (v + 1, v)]
+    if v + n <= n * n:
+        edges += [(v, v + n), (v + n, v)]
+DiGraphSet.set_universe(edges)
+try:
+    DiGraphSet.directed_cycles()
+except MemoryError:
+    print('MemoryError')
+"""
+        env = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+        p = subprocess.run([sys.executable, '-c', script], env=env,
+                           stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                           universal_newlines=True)
+        self.assertEqual(p.returncode, 0, p.stderr)
+        self.assertEqual(p.stdout.strip(), 'MemoryError')
+
     def test_with_graphillion(self):
         graphillion_universe = [e1, e2, e3, e4, e5, e6, e7]
         GraphSet.set_universe(graphillion_universe)
@@ -180,6 +180,8 @@ class TestDiGraphSet(unittest.TestCase):
         self.assertEqual(gs.graph_size(3), DiGraphSet([g123, g134]))
         self.assertTrue(isinstance(gs.len(3), DiGraphSet))
         self.assertEqual(gs.len(3), DiGraphSet([g123, g134]))
+        self.assertEqual(gs.size_histogram(), {0: 1, 1: 2, 2: 2, 3: 2, 4: 1})
+        self.assertEqual(DiGraphSet().size_histogram(), {})
 
         gs = DiGraphSet([g12, g123, g234])
         self.assertTrue(isinstance(gs.minimal(), DiGraphSet))
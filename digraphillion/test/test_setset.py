@@ -157,6 +157,9 @@ class TestSetset(unittest.TestCase):
         self.assertEqual(ss.set_size(3), setset([s123, s134]))
         self.assertTrue(isinstance(ss.len(3), setset))
         self.assertEqual(ss.len(3), setset([s123, s134]))
+        self.assertEqual(ss.size_histogram(), [1, 2, 2, 2, 1])
+        self.assertEqual(ss.larger(4), setset())
+        self.assertEqual(ss.smaller(0), setset())
 
         ss = setset([s12, s123, s234])
         self.assertTrue(isinstance(ss.minimal(), setset))
@@ -301,6 +304,12 @@ class TestSetset(unittest.TestCase):
         self.assertTrue(isinstance(ss, setset))
         self.assertEqual(ss, setset([s0, s1, s4]))
 
+        ss = setset([s0]).non_supersets(setset([s0, s1]))
+        self.assertEqual(ss, setset())
+
+        ss = setset(u).non_subsets(setset([s0]))
+        self.assertEqual(ss, setset(u) - setset([s0]))
+
         ss1 = setset([s0, s12, s13])
         ss2 = ss1.supersets('1')
         self.assertTrue(isinstance(ss2, setset))
@@ -350,6 +359,18 @@ class TestSetset(unittest.TestCase):
         self.assertEqual(len(v), 3)
         self.assertEqual(ss, setset(v))
 
+        # the sets are taken in batches across the iteration
+        ss = setset({})
+        v = list(ss)
+        self.assertEqual(len(v), 16)
+        self.assertEqual(ss, setset(v))
+
+        import _digraphillion
+        i = _digraphillion.setset.iter(setset([s0, s12, s13]))
+        self.assertEqual(len(i.next_n(2)), 2)
+        self.assertEqual(len(i.next_n(2)), 1)
+        self.assertEqual(i.next_n(2), [])
+
         ss1 = setset([s0, s12, s13])
         ss2 = setset()
         for s in ss1.rand_iter():
@@ -359,6 +380,21 @@ class TestSetset(unittest.TestCase):
         gen = ss1.rand_iter()
         self.assertTrue(isinstance(next(gen), set))
 
+        v = ss1.sample(20)
+        self.assertEqual(len(v), 20)
+        self.assertTrue(all(s in ss1 for s in v))
+        v = ss1.sample(3, replace=False)
+        self.assertEqual(ss1, setset(v))
+        self.assertEqual(ss1.sample(0, replace=False), [])
+        self.assertRaises(ValueError, ss1.sample, 4, False)
+        self.assertRaises(ValueError, setset().sample, 1)
+
+        # beyond 2^64 sets, only the probabilities of the branches are kept
+        setset.set_universe(list(range(100)))
+        v = setset({}).sample(10)
+        self.assertEqual(len(v), 10)
+        setset.set_universe(['1', '2', '3', '4'])
+
         ss = setset([s0, s1, s12, s123, s1234, s134, s14, s4])
         r = []
         for s in ss.max_iter({'1': .3, '2': -.2, '3': -.2}, default=.4):
@@ -472,6 +508,15 @@ class TestSetset(unittest.TestCase):
         ss = setset([s0, s1, s2, s12, s13, s1234])
         self.assertAlmostEqual(ss.probability(p), .4728)
 
+        q = {'1': 1, '2': .5, '3': 0, '4': .5}
+        ps = ss.probabilities([p, q, p])
+        self.assertEqual(len(ps), 3)
+        self.assertAlmostEqual(ps[0], .4728)
+        self.assertAlmostEqual(ps[1], .5)
+        self.assertAlmostEqual(ps[2], .4728)
+        self.assertEqual(ss.probabilities([]), [])
+        self.assertEqual(setset().probabilities([p]), [0])
+
     def test_io(self):
         ss = setset()
         st = ss.dumps()
@@ -514,6 +559,17 @@ class TestSetset(unittest.TestCase):
                 break
             i += 1
 
+        # the counts exceed the multi-word integers of bddcardmp10
+        n = 1100
+        setset.set_universe(range(n))
+        ss = setset({})
+        self.assertEqual(ss.len(), 2**n)
+        ss -= setset([set([1]), set([1, 2])])
+        self.assertEqual(ss.len(), 2**n - 2)
+        self.assertEqual(ss.supersets(1).len(), 2**(n - 1) - 2)
+        self.assertEqual(ss.non_supersets(1).len(), 2**(n - 1))
+        self.assertEqual(ss.supersets(1).supersets(2).len(), 2**(n - 2) - 1)
+
          # it takes more than 10 sec.
 #        self.assertRaises(RuntimeError, setset.set_universe, range(65536))
 
@@ -9,6 +9,7 @@ import release
 root_dir = os.path.normpath(os.path.join(__file__, os.pardir))
 ext_module_sources = [
     os.path.join(root_dir, 'src', 'pydigraphillion.cc'),
+    os.path.join(root_dir, 'src', 'digraphillion', 'edge_order.cc'),
     os.path.join(root_dir, 'src', 'digraphillion', 'graphset.cc'),
     os.path.join(root_dir, 'src', 'digraphillion', 'setset.cc'),
     os.path.join(root_dir, 'src', 'digraphillion', 'zdd.cc'),
@@ -24,8 +25,8 @@ setup(
         include_dirs=['src', 'src/SAPPOROBDD'],
         libraries=[],
         define_macros=[('B_64', None)],
-        extra_compile_args=['-march=native'],
-        extra_link_args=[],
+        extra_compile_args=['-march=native', '-fopenmp'],
+        extra_link_args=['-fopenmp'],
     ), ],
     author=release.authors[0][0],
     author_email=release.authors[0][1],
@@ -74,6 +74,7 @@ public:
   bddword Lit(void) const { return bddlit(_zbdd); }
   bddword Len(void) const { return bddlen(_zbdd); }
   char* CardMP16(char* s) const { return bddcardmp16(_zbdd, s); }
+  char* CardMP10(char* s) const { return bddcardmp10(_zbdd, s); }
 
   void Export(FILE *strm = stdout) const;
   void XPrint(void) const;
@@ -123,6 +124,24 @@ extern ZBDD ZBDD_LCM_M(char *, int);
 inline ZBDD ZBDD_ID(bddword zbdd)
   { ZBDD h; h._zbdd = zbdd; return h; }
 
+inline ZBDD ZBDD_Node(int v, const ZBDD& f0, const ZBDD& f1)
+  { return ZBDD_ID(bddgetznode(v, f0.GetID(), f1.GetID())); }
+
+inline ZBDD ZBDD_Minimal(const ZBDD& f)
+  { return ZBDD_ID(bddminimal(f.GetID())); }
+
+inline ZBDD ZBDD_Maximal(const ZBDD& f)
+  { return ZBDD_ID(bddmaximal(f.GetID())); }
+
+inline ZBDD ZBDD_NonSubsets(const ZBDD& f, const ZBDD& g)
+  { return ZBDD_ID(bddnonsubsets(f.GetID(), g.GetID())); }
+
+inline ZBDD ZBDD_NonSupersets(const ZBDD& f, const ZBDD& g)
+  { return ZBDD_ID(bddnonsupersets(f.GetID(), g.GetID())); }
+
+inline ZBDD ZBDD_Complement(const ZBDD& f, int lev)
+  { return ZBDD_ID(bddcomplement(f.GetID(), lev)); }
+
 inline ZBDD BDD_CacheZBDD(char op, bddword fx, bddword gx)
   { return ZBDD_ID(bddcopy(bddrcache(op, fx, gx))); }
 
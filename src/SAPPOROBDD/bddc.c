@@ -30,6 +30,13 @@
 #define BC_LIT        17
 #define BC_LEN        18
 #define BC_CARD2      19
+/* Set family operations, whose IDs are apart from those of BDD.cc and
+   ZBDD.cc since they are not less than 20 */
+#define BC_MINIMAL    70
+#define BC_MAXIMAL    71
+#define BC_NONSUBSETS 72
+#define BC_NONSUPSETS 73
+#define BC_COMPLEMENT 76
 
 /* Macros for malloc, realloc */
 #define B_MALLOC(type, size) \
@@ -231,6 +238,11 @@ struct B_MP
   bddp word[B_MP_LMAX];
 };
 
+/* Declaration of Count-Memo, which is indexed by the nodes and keeps the
+   counts of them in the form of the results of BC_CARD2 (0 if unknown) */
+static bddp *CardMemo = 0;
+static bddp CardMemoSpc = 0;
+
 /* ----- Declaration of static (internal) functions ------ */
 /* Private procedure */
 static int  err B_ARG((char *msg, bddp num));
@@ -243,6 +255,7 @@ static bddp getnode B_ARG((bddvar v, bddp f0, bddp f1));
 static bddp getbddp B_ARG((bddvar v, bddp f0, bddp f1));
 static bddp getzbddp B_ARG((bddvar v, bddp f0, bddp f1));
 static bddp apply B_ARG((bddp f, bddp g, unsigned char op, unsigned char skip));
+static bddp complement B_ARG((bddp f, bddvar lev, bddvar low));
 static void gc1 B_ARG((struct B_NodeTable *np));
 static bddp count B_ARG((bddp f));
 static void dump B_ARG((bddp f));
@@ -252,6 +265,8 @@ static int import B_ARG((FILE *strm, bddp *p, int lim, int z));
 static int andfalse B_ARG((bddp f, bddp g));
 
 static int mp_add B_ARG((struct B_MP *p, bddp ix));
+static bddp mp_store B_ARG((struct B_MP *p));
+static bddp cardmp B_ARG((bddp f));
 
 /* ------------------ Body of program -------------------- */
 /* ----------------- External functions ------------------ */
@@ -352,6 +367,10 @@ bddp limitsize;
     if(mptable[i].word) { free(mptable[i].word); mptable[i].word = 0; }
   }
 
+  /* Init Count-Memo */
+  if(CardMemo){ free(CardMemo); CardMemo = 0; }
+  CardMemoSpc = 0;
+
   return 0;
 }
 
@@ -416,6 +435,10 @@ int bddgc()
     case BC_UNION:
     case BC_SUBTRACT:
     case BC_CHANGE:
+    case BC_MINIMAL:
+    case BC_MAXIMAL:
+    case BC_NONSUBSETS:
+    case BC_NONSUPSETS:
       f = B_GET_BDDP(cachep->f);
       if(!B_CST(f) && (fp=B_NP(f))<Node+NodeSpc && fp->varrfc == 0)
       {
@@ -439,6 +462,7 @@ int bddgc()
     case BC_AT1:
     case BC_OFFSET:
     case BC_ONSET:
+    case BC_COMPLEMENT:
       f = B_GET_BDDP(cachep->f);
       if(!B_CST(f) && (fp=B_NP(f))<Node+NodeSpc && fp->varrfc == 0)
       {
@@ -483,6 +507,10 @@ int bddgc()
     mptable[i].word = 0;
   }
 
+  /* Count-Memo clear, where the counts in MP-Count table are lost */
+  for(i=0; i<CardMemoSpc; i++)
+    if(CardMemo[i] > bddnull || Node[i].varrfc == 0) CardMemo[i] = 0;
+
   /* Hash-table packing */
   for(v=1; v<=VarUsed; v++)
   {
@@ -770,10 +798,15 @@ bddvar bddnewvaroflev(lev)
 bddvar  lev;
 {
   bddvar i;
+  struct B_CacheTable *cachep;
 
   if(lev == 0 || lev > ++VarUsed)
     err("bddnewvaroflev: Invalid level", lev);
   if(VarUsed == VarSpc) var_enlarge();
+  /* The ranges of complement() in the cache may get a new variable */
+  if(lev > 1)
+    for(cachep=Cache; cachep<Cache+CacheSpc; cachep++)
+      if(cachep->op == BC_COMPLEMENT) cachep->op = BC_NULL;
   for(i=VarUsed; i>lev; i--) Var[ VarID[i] = VarID[i-1U] ].lev = i;
   Var[ VarID[lev] = VarUsed ].lev = lev;
   return VarUsed;
@@ -1265,6 +1298,138 @@ bddp f, g;
   return apply(f, g, BC_SUBTRACT, 0);
 }
 
+bddp bddminimal(f)
+bddp f;
+/* Returns the sets in f which have no proper subset in f.
+   Returns bddnull if not enough memory */
+{
+  struct B_NodeTable *fp;
+
+  /* Check operands */
+  if(f == bddnull) return bddnull;
+  if(B_CST(f))
+  { if(B_ABS(f) != bddfalse) err("bddminimal: Invalid bddp", f); }
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddminimal: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddminimal: applying non-ZBDD node", f);
+  }
+
+  return apply(f, bddfalse, BC_MINIMAL, 0);
+}
+
+bddp bddmaximal(f)
+bddp f;
+/* Returns the sets in f which have no proper superset in f.
+   Returns bddnull if not enough memory */
+{
+  struct B_NodeTable *fp;
+
+  /* Check operands */
+  if(f == bddnull) return bddnull;
+  if(B_CST(f))
+  { if(B_ABS(f) != bddfalse) err("bddmaximal: Invalid bddp", f); }
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddmaximal: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddmaximal: applying non-ZBDD node", f);
+  }
+
+  return apply(f, bddfalse, BC_MAXIMAL, 0);
+}
+
+bddp bddnonsubsets(f, g)
+bddp f, g;
+/* Returns the sets in f which are not subsets of any set in g.
+   Returns bddnull if not enough memory */
+{
+  struct B_NodeTable *fp;
+
+  /* Check operands */
+  if(f == bddnull) return bddnull;
+  if(g == bddnull) return bddnull;
+  if(B_CST(f))
+  { if(B_ABS(f) != bddfalse) err("bddnonsubsets: Invalid bddp", f); }
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddnonsubsets: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddnonsubsets: applying non-ZBDD node", f);
+  }
+  if(B_CST(g))
+  { if(B_ABS(g) != bddfalse) err("bddnonsubsets: Invalid bddp", g); }
+  else
+  {
+    fp = B_NP(g);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddnonsubsets: Invalid bddp", g);
+    if(!B_Z_NP(fp)) err("bddnonsubsets: applying non-ZBDD node", g);
+  }
+
+  return apply(f, g, BC_NONSUBSETS, 0);
+}
+
+bddp bddnonsupersets(f, g)
+bddp f, g;
+/* Returns the sets in f which are not supersets of any set in g.
+   Returns bddnull if not enough memory */
+{
+  struct B_NodeTable *fp;
+
+  /* Check operands */
+  if(f == bddnull) return bddnull;
+  if(g == bddnull) return bddnull;
+  if(B_CST(f))
+  { if(B_ABS(f) != bddfalse) err("bddnonsupersets: Invalid bddp", f); }
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddnonsupersets: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddnonsupersets: applying non-ZBDD node", f);
+  }
+  if(B_CST(g))
+  { if(B_ABS(g) != bddfalse) err("bddnonsupersets: Invalid bddp", g); }
+  else
+  {
+    fp = B_NP(g);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddnonsupersets: Invalid bddp", g);
+    if(!B_Z_NP(fp)) err("bddnonsupersets: applying non-ZBDD node", g);
+  }
+
+  return apply(f, g, BC_NONSUPSETS, 0);
+}
+
+bddp bddcomplement(f, lev)
+bddp f;
+bddvar lev;
+/* Returns the complement of f in the power set of the variables
+   whose levels are higher than lev, where the sets of f with the other
+   variables are ignored */
+{
+  struct B_NodeTable *fp;
+
+  if(lev > VarUsed) err("bddcomplement: Invalid level", lev);
+  if(f == bddnull) return bddnull;
+  if(B_CST(f))
+  { if(B_ABS(f) != bddfalse) err("bddcomplement: Invalid bddp", f); }
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddcomplement: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddcomplement: applying non-ZBDD node", f);
+  }
+
+  return complement(f, VarUsed, lev);
+}
+
 bddp bddcard(f)
 bddp f;
 {
@@ -1362,6 +1527,73 @@ char *s;
   return s;
 }
 
+char *bddcardmp10(f, s)
+bddp f;
+char *s;
+/* Returns the count of f in decimal, which is empty on overflow */
+{
+  struct B_NodeTable *fp;
+  int i, j, k, n, nz;
+  struct B_MP mp;
+  bddp h, spc;
+  unsigned long r, limb[B_MP_LMAX*sizeof(bddp)/2];
+
+  mp.len = 1;
+  if(f == bddnull) mp.word[0] = 0;
+  else if(B_CST(f)) mp.word[0] = (f == bddtrue)? 1: 0;
+  else
+  {
+    fp = B_NP(f);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddcardmp10: Invalid bddp", f);
+    if(!B_Z_NP(fp)) err("bddcardmp10: applying non-ZBDD node", f);
+
+    /* Count-Memo follows Node-Table, which may be enlarged */
+    if(CardMemoSpc < NodeSpc)
+    {
+      bddp *memo = B_REALLOC(CardMemo, bddp, NodeSpc);
+      if(memo)
+      {
+        for(spc=CardMemoSpc; spc<NodeSpc; spc++) memo[spc] = 0;
+        CardMemo = memo;
+        CardMemoSpc = NodeSpc;
+      }
+    }
+    h = (CardMemoSpc < NodeSpc)? B_MP_NULL: cardmp(B_ABS(f));
+    mp.word[0] = B_NEG(f)? 1: 0;
+    if(mp_add(&mp, h)) mp.len = 0;
+  }
+
+  /* 16-bit limbs from the most significant one */
+  n = mp.len * (int)sizeof(bddp) / 2;
+  for(i=0; i<n; i++)
+    limb[n-1-i] = (unsigned long)(mp.word[i/(sizeof(bddp)/2)]
+                  >> ((i%(sizeof(bddp)/2))*16)) & 0xFFFF;
+
+  if(!s) s = B_MALLOC(char, mp.len*sizeof(bddp)*3+1);
+  if(!s) return s;
+  k = 0;
+  do
+  {
+    /* Divides the limbs by 10000 and writes the remainder backward */
+    r = 0;
+    nz = 0;
+    for(i=0; i<n; i++)
+    {
+      r = (r << 16) | limb[i];
+      limb[i] = r / 10000;
+      r %= 10000;
+      if(limb[i]) nz = 1;
+    }
+    for(j=0; j<4 && (nz || r); j++) { s[k++] = (char)('0' + r % 10); r /= 10; }
+  } while(nz);
+  if(k == 0 && mp.len) s[k++] = '0';
+  for(i=0, j=k-1; i<j; i++, j--) { char c = s[i]; s[i] = s[j]; s[j] = c; }
+  s[k] = 0;
+
+  return s;
+}
+
 int bddimport(strm, p, lim)
 FILE *strm;
 bddp *p;
@@ -1419,6 +1651,70 @@ bddvar 	v;
   return getzbddp(v, bddfalse, f);
 }
 
+bddp    bddgetznode(v, f0, f1)
+bddvar  v;
+bddp    f0, f1;
+/* Returns the ZBDD node (v, f0, f1) from the unique table without any
+   apply operation. f0 and f1 must be ZBDDs below the level of v.
+   Returns bddnull if not enough memory */
+{
+  struct B_NodeTable *fp;
+  bddp h;
+
+  /* Check operands */
+  if(v > VarUsed || v == 0) err("bddgetznode: Invalid VarID", v);
+  if(f0 == bddnull || f1 == bddnull) return bddnull;
+  if(!B_CST(f0))
+  {
+    fp = B_NP(f0);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddgetznode: Invalid bddp", f0);
+    if(!B_Z_NP(fp)) err("bddgetznode: applying non-ZBDD node", f0);
+    if(Var[B_VAR_NP(fp)].lev >= Var[v].lev)
+      err("bddgetznode: Invalid level", f0);
+  }
+  if(!B_CST(f1))
+  {
+    fp = B_NP(f1);
+    if(fp>=Node+NodeSpc || !fp->varrfc)
+      err("bddgetznode: Invalid bddp", f1);
+    if(!B_Z_NP(fp)) err("bddgetznode: applying non-ZBDD node", f1);
+    if(Var[B_VAR_NP(fp)].lev >= Var[v].lev)
+      err("bddgetznode: Invalid level", f1);
+  }
+
+  /* The new node takes over the references to f0 and f1 */
+  if(!B_CST(f0)) { fp = B_NP(f0); B_RFC_INC_NP(fp); }
+  if(!B_CST(f1)) { fp = B_NP(f1); B_RFC_INC_NP(fp); }
+  h = getzbddp(v, f0, f1);
+  if(h == bddnull) { bddfree(f0); bddfree(f1); } /* Overflow */
+  return h;
+}
+
+bddp    bddgetzchild(f, b)
+bddp    f;
+int     b;
+/* Returns the b-child of the top node of ZBDD f without any apply
+   operation. The reference count is not incremented, so the child
+   is valid only while f is referred. */
+{
+  struct B_NodeTable *fp;
+  bddp f0;
+
+  /* Check operands */
+  if(f == bddnull) return bddnull;
+  if(B_CST(f)) err("bddgetzchild: Constant node", f);
+  fp = B_NP(f);
+  if(fp>=Node+NodeSpc || !fp->varrfc)
+    err("bddgetzchild: Invalid bddp", f);
+  if(!B_Z_NP(fp)) err("bddgetzchild: applying non-ZBDD node", f);
+
+  if(b) return B_GET_BDDP(fp->f1);
+  /* The 0-edge is stored negated unless f is negated */
+  f0 = B_GET_BDDP(fp->f0);
+  return B_NEG(f)? f0: B_NOT(f0);
+}
+
 /* ----------------- Internal functions ------------------ */
 static void var_enlarge()
 {
@@ -1658,6 +1954,7 @@ bddp    f0, f1;
   struct B_NodeTable *np, *fp;
   struct B_VarTable *varp;
   bddp ix, nx, key;
+  int gc;
   bddp_32 *p_32;
 #ifdef B_64
   bddp_h8 *p_h8;
@@ -1719,10 +2016,14 @@ bddp    f0, f1;
   /* Check node-table overflow */
   if(NodeUsed >= NodeSpc-1U)
   {
-    if(node_enlarge())
+    /* Dead nodes are collected before enlarging the table, which is
+       enlarged only if less than a quarter of the table is freed */
+    gc = bddgc();
+    key = B_HASHKEY(f0, f1, varp->hashSpc);
+    if(gc || NodeUsed >= NodeSpc - (NodeSpc>>2))
     {
-      if(bddgc()) return bddnull; /* Node-table overflow */
-      key = B_HASHKEY(f0, f1, varp->hashSpc);
+      if(node_enlarge() && NodeUsed >= NodeSpc-1U)
+        return bddnull; /* Node-table overflow */
     }
     /* Node-table enlarged or GC succeeded */
   }
@@ -1932,6 +2233,38 @@ unsigned char op, skip;
     if(B_NEG(f)) f = B_NOT(f);
     break;
 
+  case BC_MINIMAL:
+    /* Check trivial cases */
+    if(B_CST(f)) return f;
+    if(B_NEG(f)) return bddtrue; /* The empty set is a subset of all */
+    break;
+
+  case BC_MAXIMAL:
+    /* Check trivial cases */
+    if(B_CST(f)) return f;
+    break;
+
+  case BC_NONSUBSETS:
+    /* Check trivial cases */
+    if(g == bddfalse)
+    {
+      if(!B_CST(f)) { fp=B_NP(f); B_RFC_INC_NP(fp); }
+      return f;
+    }
+    if(B_CST(f) || f == g) return bddfalse;
+    if(g == bddtrue) { fp=B_NP(f); B_RFC_INC_NP(fp); return B_ABS(f); }
+    break;
+
+  case BC_NONSUPSETS:
+    /* Check trivial cases */
+    if(f == bddfalse || f == g || B_NEG(g)) return bddfalse;
+    if(B_CST(f) || g == bddfalse)
+    {
+      if(!B_CST(f)) { fp=B_NP(f); B_RFC_INC_NP(fp); }
+      return f;
+    }
+    break;
+
   case BC_CHANGE: 
     /* Check trivial cases */
     if(f == bddfalse) return f;
@@ -2012,6 +2345,8 @@ unsigned char op, skip;
   case BC_INTERSEC:
   case BC_UNION:
   case BC_SUBTRACT:
+  case BC_NONSUBSETS:
+  case BC_NONSUPSETS:
     /* Try cache? */
     if((B_CST(f) || B_RFC_ONE_NP(B_NP(f))) &&
        (B_CST(g) || B_RFC_ONE_NP(B_NP(g)))) key = bddnull;
@@ -2077,6 +2412,8 @@ unsigned char op, skip;
   case BC_OFFSET:
   case BC_ONSET:
   case BC_CHANGE:
+  case BC_MINIMAL:
+  case BC_MAXIMAL:
     fp = B_NP(f);
     if(B_RFC_ONE_NP(fp)) key = bddnull;
     else
@@ -2227,6 +2564,65 @@ unsigned char op, skip;
     if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
     break;
 
+  case BC_MINIMAL:
+    h0 = apply(f0, bddfalse, op, 0);
+    if(h0 == bddnull) { h = h0; break; } /* Overflow */
+    h = apply(f1, bddfalse, op, 0);
+    if(h == bddnull) { bddfree(h0); break; } /* Overflow */
+    /* Sets with v are removed by their subsets without v */
+    h1 = apply(h, h0, BC_NONSUPSETS, 0);
+    bddfree(h);
+    if(h1 == bddnull) { bddfree(h0); h = h1; break; } /* Overflow */
+    h = getzbddp(v, h0, h1);
+    if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
+    break;
+
+  case BC_MAXIMAL:
+    h1 = apply(f1, bddfalse, op, 0);
+    if(h1 == bddnull) { h = h1; break; } /* Overflow */
+    h = apply(f0, bddfalse, op, 0);
+    if(h == bddnull) { bddfree(h1); break; } /* Overflow */
+    /* Sets without v are removed by their supersets with v */
+    h0 = apply(h, h1, BC_NONSUBSETS, 0);
+    bddfree(h);
+    if(h0 == bddnull) { bddfree(h1); h = h0; break; } /* Overflow */
+    h = getzbddp(v, h0, h1);
+    if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
+    break;
+
+  case BC_NONSUBSETS:
+    /* Sets without v are subsets of sets in either g0 or g1 */
+    h = apply(g0, g1, BC_UNION, 0);
+    if(h == bddnull) break; /* Overflow */
+    h0 = apply(f0, h, op, 0);
+    bddfree(h);
+    if(h0 == bddnull) { h = h0; break; } /* Overflow */
+    h1 = apply(f1, g1, op, 0);
+    if(h1 == bddnull) { bddfree(h0); h = h1; break; } /* Overflow */
+    h = getzbddp(v, h0, h1);
+    if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
+    break;
+
+  case BC_NONSUPSETS:
+    /* Sets with v are supersets of sets in either g0 or g1 */
+    h0 = apply(f0, g0, op, 0);
+    if(h0 == bddnull) { h = h0; break; } /* Overflow */
+    h = apply(f1, g0, op, 0);
+    if(h == bddnull) { bddfree(h0); break; } /* Overflow */
+    h1 = apply(f1, g1, op, 0);
+    if(h1 == bddnull) { bddfree(h0); bddfree(h); h = h1; break; } /* Overflow */
+    {
+      bddp h2;
+
+      h2 = apply(h, h1, BC_INTERSEC, 0);
+      bddfree(h); bddfree(h1);
+      h1 = h2;
+    }
+    if(h1 == bddnull) { bddfree(h0); h = h1; break; } /* Overflow */
+    h = getzbddp(v, h0, h1);
+    if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
+    break;
+
   case BC_SUPPORT:
     h0 = apply(f0, bddfalse, op, 0);
     if(h0 == bddnull) { h = h0; break; } /* Overflow */
@@ -2287,9 +2683,6 @@ unsigned char op, skip;
     if(h1 == B_MP_NULL) { h = h1; break; }
     {
       struct B_MP mp;
-      struct B_MPTable *mpt;
-      bddp i, size2;
-      bddp *wp;
 
       mp.len = 1;
       mp.word[0] = 0;
@@ -2297,31 +2690,7 @@ unsigned char op, skip;
       if(B_NEG(f1)) mp.word[0]++;
       mp_add(&mp, h0);
       mp_add(&mp, h1);
-      if(mp.len == 1 && mp.word[0] <= bddnull)
-        { h = mp.word[0]; break; }
-      mpt = mptable + mp.len-1;
-      if(mpt->word == 0)
-      {
-        mpt->size = 16;
-        mpt->used = 0;
-        mpt->word = B_MALLOC(bddp, mp.len * mpt->size);
-      }
-      if(mpt->size == mpt->used)
-      {
-        size2 = mpt->size << 1;
-	if(size2 > (B_CST_MASK>>B_MP_LWID)) { h = B_MP_NULL; break; }
-	wp = 0;
-        wp = B_MALLOC(bddp, mp.len * size2);
-	if(!wp) { h = B_MP_NULL; break; }
-	for(i=0; i<mp.len*(mpt->size); i++) wp[i] = mpt->word[i];
-        mpt->size = size2;
-	free(mpt->word);
-	mpt->word = wp;
-      }
-      wp = mpt->word;
-        
-      for(i=0; i<(bddp)mp.len; i++) wp[mp.len*(mpt->used)+i] = mp.word[i];
-      h = (((bddp)mp.len-1)<<B_MP_LPOS) + B_CST_MASK + (mpt->used++);
+      h = mp_store(&mp);
       break;
     }
   case BC_LIT:
@@ -2397,6 +2766,82 @@ unsigned char op, skip;
   return h;
 }
 
+static bddp complement(f, lev, low)
+bddp f;
+bddvar lev, low;
+/* Returns the complement of f in the power set of the variables whose
+   levels are in (low, lev], where f has no variable above lev */
+{
+  struct B_NodeTable *fp;
+  struct B_CacheTable *cachep;
+  bddp f0, f1, h0, h1, h, g, key;
+  bddvar v;
+
+  /* Only the empty set is left in the power set */
+  if(lev == low) return B_NEG(f)? bddfalse: bddtrue;
+
+  /* Try cache?  A node referred only once is reached only once at each
+     level, while the chains from constants are shared by all */
+  g = ((bddp)VarID[low + 1U] << B_VAR_WIDTH) | VarID[lev];
+  if(!B_CST(f) && B_RFC_ONE_NP(B_NP(f))) key = bddnull;
+  else
+  {
+    /* Checking Cache, where g is the pair of the variables at the ends
+       of the range, which are kept while new variables are added below */
+    key = B_CACHEKEY(BC_COMPLEMENT, f, g);
+    cachep = Cache + key;
+    if(cachep->op == BC_COMPLEMENT &&
+       f == B_GET_BDDP(cachep->f) &&
+       g == B_GET_BDDP(cachep->g))
+    {
+      /* Hit */
+      h = B_GET_BDDP(cachep->h);
+      if(!B_CST(h) && h != bddnull) { fp = B_NP(h); B_RFC_INC_NP(fp); }
+      return h;
+    }
+  }
+
+  /* Get (f0, f1) for the variable of lev, which may be skipped in f */
+  v = VarID[lev];
+  f0 = f; f1 = bddfalse;
+  if(!B_CST(f) && Var[B_VAR_NP(fp = B_NP(f))].lev == lev)
+  {
+    f0 = B_GET_BDDP(fp->f0);
+    f1 = B_GET_BDDP(fp->f1);
+    if(B_NEG(f)^B_NEG(f0)) f0 = B_NOT(f0);
+  }
+
+  /* Stack overflow limitter */
+  BDD_RECUR_INC;
+
+  h = complement(f0, lev - 1, low);
+  if(h != bddnull)
+  {
+    h0 = h;
+    h1 = complement(f1, lev - 1, low);
+    if(h1 == bddnull) { bddfree(h0); h = h1; } /* Overflow */
+    else
+    {
+      h = getzbddp(v, h0, h1);
+      if(h == bddnull) { bddfree(h0); bddfree(h1); } /* Overflow */
+    }
+  }
+
+  /* Stack overflow limitter */
+  BDD_RECUR_DEC;
+
+  /* Saving to Cache */
+  if(key != bddnull && h != bddnull)
+  {
+    cachep = Cache + key;
+    cachep->op = BC_COMPLEMENT;
+    B_SET_BDDP(cachep->f, f);
+    B_SET_BDDP(cachep->g, g);
+    B_SET_BDDP(cachep->h, h);
+  }
+  return h;
+}
+
 static void gc1(np)
 struct B_NodeTable *np;
 {
@@ -3026,6 +3471,79 @@ int z;
   return 0;
 }
 
+static bddp mp_store(p)
+struct B_MP *p;
+/* Returns the index of p in MP-Count table, or p itself if it fits */
+{
+  struct B_MPTable *mpt;
+  bddp i, size2;
+  bddp *wp;
+
+  if(p->len == 1 && p->word[0] <= bddnull) return p->word[0];
+  mpt = mptable + p->len-1;
+  if(mpt->word == 0)
+  {
+    mpt->size = 16;
+    mpt->used = 0;
+    mpt->word = B_MALLOC(bddp, p->len * mpt->size);
+    if(!mpt->word) return B_MP_NULL;
+  }
+  if(mpt->size == mpt->used)
+  {
+    size2 = mpt->size << 1;
+    if(size2 > (B_CST_MASK>>B_MP_LWID)) return B_MP_NULL;
+    wp = 0;
+    wp = B_MALLOC(bddp, p->len * size2);
+    if(!wp) return B_MP_NULL;
+    for(i=0; i<p->len*(mpt->size); i++) wp[i] = mpt->word[i];
+    mpt->size = size2;
+    free(mpt->word);
+    mpt->word = wp;
+  }
+  wp = mpt->word;
+
+  for(i=0; i<(bddp)p->len; i++) wp[p->len*(mpt->used)+i] = p->word[i];
+  return (((bddp)p->len-1)<<B_MP_LPOS) + B_CST_MASK + (mpt->used++);
+}
+
+static bddp cardmp(f)
+bddp f;
+/* Returns the count of f without the inverter in the form of BC_CARD2,
+   which is kept in Count-Memo until f is freed */
+{
+  struct B_NodeTable *fp;
+  bddp f0, f1, h0, h1, h;
+  struct B_MP mp;
+
+  h = CardMemo[B_NDX(f)];
+  if(h) return h;
+
+  fp = B_NP(f);
+  f0 = B_GET_BDDP(fp->f0);
+  f1 = B_GET_BDDP(fp->f1);
+  if(B_NEG(f0)) f0 = B_NOT(f0);
+
+  /* Stack overflow limitter */
+  BDD_RECUR_INC;
+  h0 = B_CST(B_ABS(f0))? 0: cardmp(B_ABS(f0));
+  h1 = B_CST(B_ABS(f1))? 0: cardmp(B_ABS(f1));
+  BDD_RECUR_DEC;
+
+  /* Adds them in a word if they fit, where the sum cannot overflow */
+  h = (B_NEG(f0)? 1: 0) + (B_NEG(f1)? 1: 0);
+  if(h0 == B_MP_NULL || h1 == B_MP_NULL) h = B_MP_NULL;
+  else if(h0 <= bddnull && h1 <= bddnull && h + h0 + h1 <= bddnull)
+    h += h0 + h1;
+  else
+  {
+    mp.len = 1;
+    mp.word[0] = h;
+    h = (mp_add(&mp, h0) || mp_add(&mp, h1))? B_MP_NULL: mp_store(&mp);
+  }
+  CardMemo[B_NDX(f)] = h;
+  return h;
+}
+
 int mp_add(p, ix)
 struct B_MP *p;
 bddp ix;
@@ -117,13 +117,21 @@ extern bddp   bddchange B_ARG((bddp f, bddvar v));
 extern bddp   bddintersec B_ARG((bddp f, bddp g));
 extern bddp   bddunion B_ARG((bddp f, bddp g));
 extern bddp   bddsubtract B_ARG((bddp f, bddp g));
+extern bddp   bddminimal B_ARG((bddp f));
+extern bddp   bddmaximal B_ARG((bddp f));
+extern bddp   bddnonsubsets B_ARG((bddp f, bddp g));
+extern bddp   bddnonsupersets B_ARG((bddp f, bddp g));
+extern bddp   bddcomplement B_ARG((bddp f, bddvar lev));
 extern bddp   bddcard B_ARG((bddp f));
 extern bddp   bddlit B_ARG((bddp f));
 extern bddp   bddlen B_ARG((bddp f));
 extern int    bddimportz B_ARG((FILE* strm, bddp* p, int lim));
 extern char  *bddcardmp16 B_ARG((bddp f, char *s));
+extern char  *bddcardmp10 B_ARG((bddp f, char *s));
 extern int    bddisbdd B_ARG((bddp f));
 extern int    bddiszbdd B_ARG((bddp f));
+extern bddp   bddgetznode B_ARG((bddvar v, bddp f0, bddp f1));
+extern bddp   bddgetzchild B_ARG((bddp f, int b));
 
 /************** SeqBDD operations *************/
 extern bddp   bddpush B_ARG((bddp f, bddvar v));
@@ -0,0 +1,350 @@
+/**
+Copyright (c) 2021 ComputerAlgorithmsGroupAtKyotoU
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "digraphillion/edge_order.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <queue>
+
+namespace digraphillion {
+
+using std::vector;
+
+FrontierWidths ComputeFrontierWidths(int num_vertices,
+                                     const vector<indexed_edge_t>& edges) {
+  const int m = edges.size();
+  vector<int> first(num_vertices, -1);
+  vector<int> last(num_vertices, -1);
+  for (int i = 0; i < m; ++i) {
+    int vs[] = {edges[i].first, edges[i].second};
+    for (int k = 0; k < 2; ++k) {
+      assert(0 <= vs[k] && vs[k] < num_vertices);
+      if (first[vs[k]] < 0) first[vs[k]] = i;
+      last[vs[k]] = i;
+    }
+  }
+
+  // a vertex is on the frontier from its first edge to its last edge
+  vector<int> diff(m + 1, 0);
+  for (int v = 0; v < num_vertices; ++v) {
+    if (first[v] < 0) continue;
+    ++diff[first[v]];
+    --diff[last[v] + 1];
+  }
+  FrontierWidths widths = {0, 0};
+  int size = 0;
+  for (int i = 0; i < m; ++i) {
+    size += diff[i];
+    widths.max = std::max(widths.max, size);
+    widths.total += size;
+  }
+  return widths;
+}
+
+namespace {
+
+// This class visits the vertices of a graph one by one and emits each
+// edge when both its endpoints have been visited.  A visited vertex stays
+// on the frontier while it has unvisited neighbors, so the next vertex is
+// chosen to minimize the change of the frontier size.
+class FrontierOrdering {
+ public:
+  FrontierOrdering(int num_vertices, const vector<indexed_edge_t>& edges)
+      : n_(num_vertices), edges_(edges), loops_(num_vertices) {
+    // merge the edges between the same pair of vertices
+    vector<std::pair<indexed_edge_t, int> > keys;
+    for (size_t i = 0; i < edges.size(); ++i) {
+      int u = edges[i].first;
+      int v = edges[i].second;
+      if (u == v) {
+        loops_[u].push_back(i);
+      } else {
+        keys.push_back(
+            std::make_pair(indexed_edge_t(std::min(u, v), std::max(u, v)), i));
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    vector<int> deg(n_, 0);
+    pair_offsets_.push_back(0);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (i == 0 || keys[i].first != keys[i - 1].first) {
+        if (i > 0) pair_offsets_.push_back(pair_edges_.size());
+        ++deg[keys[i].first.first];
+        ++deg[keys[i].first.second];
+      }
+      pair_edges_.push_back(keys[i].second);
+    }
+    if (!keys.empty()) pair_offsets_.push_back(pair_edges_.size());
+
+    adj_offsets_.assign(n_ + 1, 0);
+    for (int v = 0; v < n_; ++v) {
+      adj_offsets_[v + 1] = adj_offsets_[v] + deg[v];
+    }
+    adj_.resize(adj_offsets_[n_]);
+    vector<int> fill(adj_offsets_.begin(), adj_offsets_.end() - 1);
+    for (int p = 0; p + 1 < static_cast<int>(pair_offsets_.size()); ++p) {
+      const indexed_edge_t& e = edges_[pair_edges_[pair_offsets_[p]]];
+      int u = std::min(e.first, e.second);
+      int v = std::max(e.first, e.second);
+      adj_[fill[u]++] = Neighbor(v, p);
+      adj_[fill[v]++] = Neighbor(u, p);
+    }
+
+    for (int v = 0; v < n_; ++v) {
+      if (degree(v) > 0 || !loops_[v].empty()) by_degree_.push_back(v);
+    }
+    std::stable_sort(by_degree_.begin(), by_degree_.end(), DegreeLess(*this));
+  }
+
+  // Returns the edge order obtained by starting the traversal from source.
+  vector<int> run(int source) {
+    visited_.assign(n_, false);
+    visit_time_.assign(n_, -1);
+    unvisited_deg_.resize(n_);
+    for (int v = 0; v < n_; ++v) unvisited_deg_[v] = degree(v);
+    visited_deg_.assign(n_, 0);
+    leaving_.assign(n_, 0);
+    heap_ = std::priority_queue<Candidate>();
+
+    vector<int> order;
+    order.reserve(edges_.size());
+    size_t next_start = 0;
+    for (size_t t = 0; t < by_degree_.size(); ++t) {
+      int u = -1;
+      while (!heap_.empty() && u < 0) {
+        Candidate c = heap_.top();
+        heap_.pop();
+        if (!visited_[c.v] && c == candidate(c.v)) u = c.v;
+      }
+      if (u < 0 && t == 0 && source >= 0) u = source;
+      while (u < 0) {
+        // start a new connected component from a vertex of minimum degree
+        int v = by_degree_[next_start++];
+        if (!visited_[v]) u = v;
+      }
+      visit(u, static_cast<int>(t), order);
+    }
+    assert(order.size() == edges_.size());
+    return order;
+  }
+
+  // Returns a vertex far from v in the connected component of v,
+  // preferring a vertex of smaller degree.
+  int farthestFrom(int v) const {
+    vector<int> dist(n_, -1);
+    std::queue<int> q;
+    dist[v] = 0;
+    q.push(v);
+    int best = v;
+    while (!q.empty()) {
+      int u = q.front();
+      q.pop();
+      if (dist[u] > dist[best] ||
+          (dist[u] == dist[best] && degree(u) < degree(best))) {
+        best = u;
+      }
+      for (int k = adj_offsets_[u]; k < adj_offsets_[u + 1]; ++k) {
+        int w = adj_[k].v;
+        if (dist[w] < 0) {
+          dist[w] = dist[u] + 1;
+          q.push(w);
+        }
+      }
+    }
+    return best;
+  }
+
+  int minDegreeVertex() const {
+    return by_degree_.empty() ? -1 : by_degree_.front();
+  }
+
+ private:
+  struct Neighbor {
+    int v;  // the neighbor
+    int p;  // the index of the pair of the edges to the neighbor
+    Neighbor() : v(-1), p(-1) {}
+    Neighbor(int v, int p) : v(v), p(p) {}
+  };
+
+  // A vertex to be visited next.  The candidate that decreases the
+  // frontier size most is preferred, and ties are broken by the number of
+  // the visited neighbors (more is better) and the number of the
+  // unvisited neighbors (fewer is better).
+  struct Candidate {
+    int delta;
+    int visited_deg;
+    int unvisited_deg;
+    int v;
+
+    bool operator==(const Candidate& c) const {
+      return delta == c.delta && visited_deg == c.visited_deg &&
+             unvisited_deg == c.unvisited_deg && v == c.v;
+    }
+
+    // the top of std::priority_queue is the best candidate
+    bool operator<(const Candidate& c) const {
+      if (delta != c.delta) return delta > c.delta;
+      if (visited_deg != c.visited_deg) return visited_deg < c.visited_deg;
+      if (unvisited_deg != c.unvisited_deg) {
+        return unvisited_deg > c.unvisited_deg;
+      }
+      return v > c.v;
+    }
+  };
+
+  struct DegreeLess {
+    const FrontierOrdering& o;
+    explicit DegreeLess(const FrontierOrdering& o) : o(o) {}
+    bool operator()(int u, int v) const { return o.degree(u) < o.degree(v); }
+  };
+
+  int degree(int v) const { return adj_offsets_[v + 1] - adj_offsets_[v]; }
+
+  Candidate candidate(int v) const {
+    Candidate c;
+    c.delta = (unvisited_deg_[v] > 0 ? 1 : 0) - leaving_[v];
+    c.visited_deg = visited_deg_[v];
+    c.unvisited_deg = unvisited_deg_[v];
+    c.v = v;
+    return c;
+  }
+
+  void visit(int u, int time, vector<int>& order) {
+    visited_[u] = true;
+    visit_time_[u] = time;
+    order.insert(order.end(), loops_[u].begin(), loops_[u].end());
+
+    // emit the edges to the visited neighbors, the oldest first, so that
+    // the neighbors leave the frontier as early as possible
+    vector<std::pair<int, int> > olds;
+    for (int k = adj_offsets_[u]; k < adj_offsets_[u + 1]; ++k) {
+      const Neighbor& w = adj_[k];
+      if (visited_[w.v]) olds.push_back(std::make_pair(visit_time_[w.v], w.p));
+    }
+    std::sort(olds.begin(), olds.end());
+    for (size_t j = 0; j < olds.size(); ++j) {
+      int p = olds[j].second;
+      order.insert(order.end(), pair_edges_.begin() + pair_offsets_[p],
+                   pair_edges_.begin() + pair_offsets_[p + 1]);
+    }
+
+    for (int k = adj_offsets_[u]; k < adj_offsets_[u + 1]; ++k) {
+      int w = adj_[k].v;
+      --unvisited_deg_[w];
+      if (!visited_[w]) {
+        ++visited_deg_[w];
+        // u leaves the frontier when w, its last unvisited neighbor, is
+        // visited
+        if (unvisited_deg_[u] == 1) ++leaving_[w];
+        heap_.push(candidate(w));
+      } else if (unvisited_deg_[w] == 1) {
+        // w leaves the frontier when its last unvisited neighbor is visited
+        for (int l = adj_offsets_[w]; l < adj_offsets_[w + 1]; ++l) {
+          int x = adj_[l].v;
+          if (!visited_[x]) {
+            ++leaving_[x];
+            heap_.push(candidate(x));
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  const int n_;
+  const vector<indexed_edge_t>& edges_;
+
+  // the edges between the p-th pair of vertices are
+  // pair_edges_[pair_offsets_[p]], ..., pair_edges_[pair_offsets_[p + 1] - 1]
+  vector<int> pair_edges_;
+  vector<int> pair_offsets_;
+
+  // the neighbors of v are adj_[adj_offsets_[v]], ...,
+  // adj_[adj_offsets_[v + 1] - 1]
+  vector<Neighbor> adj_;
+  vector<int> adj_offsets_;
+
+  // the indices of the self-loops of each vertex
+  vector<vector<int> > loops_;
+
+  // the vertices incident to some edge in ascending order of degree
+  vector<int> by_degree_;
+
+  vector<bool> visited_;
+  vector<int> visit_time_;
+  vector<int> unvisited_deg_;
+  vector<int> visited_deg_;
+
+  // leaving_[v] is the number of the visited vertices that leave the
+  // frontier when v is visited
+  vector<int> leaving_;
+
+  std::priority_queue<Candidate> heap_;
+};
+
+bool IsNarrower(const FrontierWidths& a, const FrontierWidths& b) {
+  return a.max < b.max || (a.max == b.max && a.total < b.total);
+}
+
+}  // namespace
+
+vector<int> OrderEdgesByFrontier(int num_vertices,
+                                 const vector<indexed_edge_t>& edges,
+                                 int source) {
+  if (edges.empty()) return vector<int>();
+  FrontierOrdering ordering(num_vertices, edges);
+  vector<int> sources;
+  if (source >= 0) {
+    assert(source < num_vertices);
+    sources.push_back(source);
+  } else if (ordering.minDegreeVertex() >= 0) {
+    // try a vertex of minimum degree and pseudo-peripheral vertices found
+    // by repeating breadth-first searches
+    int v = ordering.minDegreeVertex();
+    for (int k = 0; k < 3; ++k) {
+      if (std::find(sources.begin(), sources.end(), v) != sources.end()) break;
+      sources.push_back(v);
+      v = ordering.farthestFrom(v);
+    }
+  }
+
+  vector<int> best;
+  FrontierWidths best_widths = {0, 0};
+  for (size_t k = 0; k < sources.size(); ++k) {
+    vector<int> order = ordering.run(sources[k]);
+    vector<indexed_edge_t> ordered_edges(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      ordered_edges[i] = edges[order[i]];
+    }
+    FrontierWidths widths = ComputeFrontierWidths(num_vertices, ordered_edges);
+    if (best.empty() || IsNarrower(widths, best_widths)) {
+      best.swap(order);
+      best_widths = widths;
+    }
+  }
+  return best;
+}
+
+}  // namespace digraphillion
@@ -0,0 +1,62 @@
+/**
+Copyright (c) 2021 ComputerAlgorithmsGroupAtKyotoU
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef DIGRAPHILLION_EDGE_ORDER_H_
+#define DIGRAPHILLION_EDGE_ORDER_H_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+namespace digraphillion {
+
+// An edge between vertices numbered from 0 to num_vertices - 1.
+typedef std::pair<int, int> indexed_edge_t;
+
+// The sizes of the frontiers in FrontierManager when the edges are
+// processed in a given order.
+struct FrontierWidths {
+  int max;        // the maximum frontier size
+  int64_t total;  // the sum of the frontier sizes over all the edges
+};
+
+// Returns the frontier widths when the edges are processed in the order
+// of `edges`.  The frontier is defined as in FrontierManager, so `max`
+// equals FrontierManager::getMaxFrontierSize().
+FrontierWidths ComputeFrontierWidths(int num_vertices,
+                                     const std::vector<indexed_edge_t>& edges);
+
+// Returns an order of the edges that keeps the frontier small, as a
+// permutation of the indices of `edges`.  The vertices are visited one by
+// one, each time choosing the vertex that shrinks the frontier most, and
+// the edges are emitted as soon as both their endpoints are visited.
+// The traversal starts from `source` if it is non-negative; otherwise it
+// is started from a few peripheral vertices and the order with the
+// smallest widths is returned.
+std::vector<int> OrderEdgesByFrontier(int num_vertices,
+                                      const std::vector<indexed_edge_t>& edges,
+                                      int source = -1);
+
+}  // namespace digraphillion
+
+#endif  // DIGRAPHILLION_EDGE_ORDER_H_
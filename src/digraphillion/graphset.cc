@@ -23,16 +23,26 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <assert.h>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <new>
+
+#include "digraphillion/zdd.h"
 #include "spec/FrontierDegreeSpecified.hpp"
 #include "spec/FrontierDirectedHamiltonianCycle.hpp"
 #include "spec/FrontierDirectedSTPath.hpp"
 #include "spec/FrontierDirectedSingleCycle.hpp"
+#include "spec/FrontierReachability.hpp"
 #include "spec/FrontierRootedForest.hpp"
 #include "spec/FrontierRootedTree.hpp"
+#include "spec/SpecEstimator.hpp"
+#include "subsetting/DdSpecOp.hpp"
 #include "subsetting/DdStructure.hpp"
-#include "subsetting/eval/ToZBDD.hpp"
 #include "subsetting/spec/SapporoZdd.hpp"
+#include "subsetting/spec/SizeConstraint.hpp"
 #include "subsetting/util/MessageHandler.hpp"
+#include "subsetting/util/Threads.hpp"
 
 namespace digraphillion {
 
@@ -42,147 +52,616 @@ using std::set;
 using std::vector;
 using namespace tdzdd;
 
-setset SearchDirectedCycles(const std::vector<edge_t>& digraph,
-                            const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+// This class holds a digraph parsed from an edge list and its frontier
+// manager, which are shared by the searches on the same universe.
+class UniverseGraph {
+ public:
+  explicit UniverseGraph(const std::vector<edge_t>& digraph) {
+    for (vector<edge_t>::const_iterator e = digraph.begin();
+         e != digraph.end(); ++e)
+      g_.addEdge(e->first, e->second);
+    g_.update();
+    assert(static_cast<size_t>(g_.edgeSize()) == digraph.size());
+    fm_.reset(new FrontierManager(g_));
+  }
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+  const Digraph& graph() const { return g_; }
+  const FrontierManager& frontierManager() const { return *fm_; }
+
+  // This function returns the reachability to v (from v if !forward)
+  // through the unprocessed edges.  Only the last table of each direction
+  // is kept, so that searches for many s-t pairs do not pile them up; it
+  // is valid until the next call in the same direction for another vertex.
+  const FrontierReachability& reachability(int v, bool forward) const {
+    pair<int, std::unique_ptr<FrontierReachability> >& r =
+        forward ? reachability_to_ : reachability_from_;
+    if (!r.second || r.first != v) {
+      r.second.reset();  // released before the next one is made
+      r.second.reset(new FrontierReachability(g_, *fm_, v, forward));
+      r.first = v;
+    }
+    return *r.second;
+  }
 
-  DdStructure<2> dd;
-  if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
-  } else {
-    dd = DdStructure<2>(g.edgeSize());
+ private:
+  Digraph g_;
+  std::unique_ptr<FrontierManager> fm_;
+  // the vertex and the table of the last reachability to and from a vertex
+  mutable pair<int, std::unique_ptr<FrontierReachability> > reachability_to_;
+  mutable pair<int, std::unique_ptr<FrontierReachability> >
+      reachability_from_;
+
+  UniverseGraph(const UniverseGraph&);
+  UniverseGraph& operator=(const UniverseGraph&);
+};
+
+// the most recently registered universe graph, the temporary graphs, and
+// the last handle given to them
+static std::unique_ptr<UniverseGraph> universe_graph_;
+static int universe_graph_handle_ = 0;
+static map<int, std::unique_ptr<UniverseGraph> > temporary_graphs_;
+static int last_graph_handle_ = 0;
+
+int RegisterUniverseGraph(const std::vector<edge_t>& digraph) {
+  universe_graph_.reset(new UniverseGraph(digraph));
+  universe_graph_handle_ = ++last_graph_handle_;
+  return universe_graph_handle_;
+}
+
+int RegisterTemporaryGraph(const std::vector<edge_t>& digraph) {
+  temporary_graphs_[++last_graph_handle_].reset(new UniverseGraph(digraph));
+  return last_graph_handle_;
+}
+
+void ReleaseTemporaryGraph(int graph_handle) {
+  temporary_graphs_.erase(graph_handle);
+}
+
+bool IsRegisteredUniverseGraph(int graph_handle) {
+  return (universe_graph_ && graph_handle == universe_graph_handle_) ||
+         temporary_graphs_.count(graph_handle) > 0;
+}
+
+static const UniverseGraph& GetUniverseGraph(int graph_handle) {
+  assert(IsRegisteredUniverseGraph(graph_handle));
+  if (graph_handle == universe_graph_handle_) return *universe_graph_;
+  return *temporary_graphs_[graph_handle];
+}
+
+// Bell numbers B(0), ..., B(n), which are computed by the Bell triangle.
+static vector<double> BellNumbers(int n) {
+  vector<double> bell(1, 1.0);
+  vector<double> row(1, 1.0);
+  for (int i = 1; i <= n; ++i) {
+    vector<double> next(i + 1);
+    next[0] = row.back();
+    for (int j = 1; j <= i; ++j) next[j] = next[j - 1] + row[j - 1];
+    row.swap(next);
+    bell.push_back(row[0]);
   }
+  return bell;
+}
 
-  FrontierDirectedSingleCycleSpec spec(g);
-  dd.zddSubset(spec);
-  dd.zddReduce();
+// This function sets the frontier sizes and the state bounds of the
+// estimate and clears the other members.  Each vertex on the frontier is
+// assumed to store its in- and out-degrees, which are at most max_degree
+// (or its degrees in the graph if max_degree < 0), and its component
+// number if has_components.
+static void SetFrontierBounds(const UniverseGraph& u, int max_degree,
+                              bool has_components, SearchEstimate* e) {
+  const Digraph& g = u.graph();
+  const FrontierManager& fm = u.frontierManager();
+  const int m = g.edgeSize();
+
+  vector<int> indeg(g.vertexSize() + 1, 0);
+  vector<int> outdeg(g.vertexSize() + 1, 0);
+  for (int i = 0; i < m; ++i) {
+    ++outdeg[g.edgeInfo(i).v1];
+    ++indeg[g.edgeInfo(i).v2];
+  }
+  if (max_degree >= 0) {
+    for (size_t v = 0; v < indeg.size(); ++v) {
+      indeg[v] = std::min(indeg[v], max_degree);
+      outdeg[v] = std::min(outdeg[v], max_degree);
+    }
+  }
+  vector<double> bell;
+  if (has_components) bell = BellNumbers(fm.getMaxFrontierSize());
+
+  e->max_frontier_size = fm.getMaxFrontierSize();
+  e->frontier_sizes.resize(m);
+  e->state_bounds.resize(m);
+  e->state_bound = 0;
+  FrontierCursor cursor(fm);
+  for (int i = 0; i < m; ++i) {
+    e->frontier_sizes[i] = fm.getFrontierSize(i);
+    // the states before the i-th edge is processed are those of the
+    // vertices remaining on the frontier after the (i - 1)-th edge
+    double bound = 1;
+    if (i > 0) {
+      const VertexList vs = cursor.getRemainingVs(i - 1);
+      for (size_t j = 0; j < vs.size(); ++j) {
+        bound *= (indeg[vs[j]] + 1.0) * (outdeg[vs[j]] + 1.0);
+      }
+      if (has_components) bound *= bell[vs.size()];
+    }
+    // at most 2^i nodes are reachable by deciding i edges
+    bound = std::min(bound, std::ldexp(1.0, std::min(i, 1024)));
+    e->state_bounds[i] = bound;
+    e->state_bound += bound;
+  }
 
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
+  e->node_counts.assign(m, 0);
+  e->nodes = 0;
+  e->seconds = 0;
+  e->memory = 0;
+  e->exact = true;
 }
 
-setset SearchDirectedHamiltonianCycles(const std::vector<edge_t>& digraph,
-                                       const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+// This function adds the cost of building a DD for the spec to the
+// estimate.  The node counts are capped by the state bounds if bounded.
+template <typename S>
+static void EstimateNodes(const S& spec, bool bounded, SearchEstimate* e) {
+  SpecEstimator<S> estimator(spec);
+  estimator.run(e->width_limit);
+
+  const vector<double>& counts = estimator.nodeCounts();
+  const int m = e->node_counts.size();
+  double nodes = 0;
+  double max_level_bytes = 0;
+  for (int level = 1; level < static_cast<int>(counts.size()); ++level) {
+    const int i = m - level;
+    double count = counts[level];
+    if (bounded) count = std::min(count, e->state_bounds[i]);
+    e->node_counts[i] += count;
+    nodes += count;
+    max_level_bytes = std::max(
+        max_level_bytes, count * (estimator.datasize(level) + sizeof(size_t)));
+  }
+  if (estimator.expandedNodes() > 0) {
+    e->seconds += estimator.seconds() * nodes / estimator.expandedNodes();
+  }
+  // the node table and the states of two levels kept by DdBuilder
+  double memory = nodes * sizeof(Node<2>) + 2 * max_level_bytes;
+  e->memory = std::max(e->memory, memory);
+  e->nodes += nodes;
+  e->exact = e->exact && estimator.isExact();
+}
+
+// This function returns the node of the DD for ZBDD f, which is numbered
+// and added to zdds when f is found for the first time.  The ZBDDs below
+// level 1 are replaced by the terminals, which are given by whether they
+// have the empty set, i.e., the bottom of their 0-edges.
+static NodeId ExportedNode(bddp f, int offset,
+                           vector<zdd_node_map<NodeId> >& ids,
+                           vector<vector<bddp> >& zdds) {
+  if (f == bddempty) return NodeId(0, 0);
+  if (f == bddsingle) return NodeId(0, 1);
+  const int level = BDD_LevOfVar(bddtop(f)) - offset;
+  if (level < 1) {
+    while (f != bddempty && f != bddsingle) f = bddgetzchild(f, 0);
+    return NodeId(0, f == bddsingle ? 1 : 0);
+  }
+  const NodeId* id = ids[level].find(f);
+  if (id != NULL) return *id;
+  const NodeId new_id(level, zdds[level].size());
+  ids[level].insert(f, new_id);
+  zdds[level].push_back(f);
+  return new_id;
+}
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+// This function converts the ZBDD into a DD, where the nodes at level
+// i + offset are at level i as SapporoZdd.  Unlike building the DD from
+// SapporoZdd, the children are read directly from the node table of
+// SAPPOROBDD level by level, without ZBDD objects or reference counting.
+// Since the nodes at a level are referred to only by the upper levels,
+// the map to them is released as soon as they are exported.
+static DdStructure<2> ExportZdd(const zdd_t& f, int offset) {
+  MessageHandler mh;
+  mh.begin("ExportZdd");
+  const int top = std::max(BDD_LevOfVar(f.Top()) - offset, 0);
+  vector<zdd_node_map<NodeId> > ids(top + 1);
+  vector<vector<bddp> > zdds(top + 1);
 
   DdStructure<2> dd;
+  dd.getDiagram() = NodeTableHandler<2>(top + 1);
+  NodeTableEntity<2>& table = dd.getDiagram().privateEntity();
+  dd.root() = ExportedNode(f.GetID(), offset, ids, zdds);
+  for (int i = top; i >= 1; --i) {
+    table.initRow(i, zdds[i].size());
+    // the next level usually has about as many nodes as this level
+    if (i > 1) ids[i - 1].reserve(zdds[i].size());
+    for (size_t j = 0; j < zdds[i].size(); ++j) {
+      for (int b = 0; b < 2; ++b) {
+        table[i][j].branch[b] =
+            ExportedNode(bddgetzchild(zdds[i][j], b), offset, ids, zdds);
+      }
+    }
+    zdd_node_map<NodeId>().swap(ids[i]);
+    vector<bddp>().swap(zdds[i]);
+  }
+  mh.end(dd.size());
+  return dd;
+}
+
+// This function estimates the cost of the subsetting by the spec, which
+// is intersected with search_space if given.
+template <typename S>
+static void EstimateSubset(const S& spec, const zdd_t* search_space,
+                           bool bounded, SearchEstimate* e) {
   if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
+    // the search space is visited lazily, since only a sample is expanded
+    SapporoZdd f(*search_space, setset::max_elem() - setset::num_elems());
+    EstimateNodes(zddIntersection(f, spec), false, e);
   } else {
-    dd = DdStructure<2>(g.edgeSize());
+    EstimateNodes(spec, bounded, e);
   }
-
-  FrontierDirectedSingleHamiltonianCycleSpec spec(g);
-  dd.zddSubset(spec);
-  dd.zddReduce();
-
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
 }
 
-setset SearchDirectedSTPath(const std::vector<edge_t>& digraph,
-                            bool is_hamiltonian, vertex_t s, vertex_t t,
-                            const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+// This function converts the DD into a ZBDD, where the nodes at level i
+// are at level i + offset.  The nodes are made level by level directly by
+// the unique table of SAPPOROBDD, which takes linear time unlike ToZBDD
+// doing the apply operations for each node.
+static zdd_t ImportZdd(const DdStructure<2>& dd, int offset) {
+  const NodeTableEntity<2>& diagram = *dd.getDiagram();
+  const NodeId root = dd.root();
+  const int n = root.row();
+  while (BDD_VarUsed() < n + offset) BDD_NewVar();
+
+  // work[i][j] holds a reference to the ZBDD of the j-th node at level i,
+  // which is appended once made so that work holds only references
+  vector<vector<bddp> > work(diagram.numRows());
+  for (size_t j = 0; j < diagram[0].size(); ++j) {
+    work[0].push_back(j == 0 ? bddempty : bddsingle);
+  }
+  for (int i = 1; i <= n; ++i) {
+    const MyVector<Node<2> >& nodes = diagram[i];
+    const bddvar v = BDD_VarOfLev(i + offset);
+    work[i].reserve(nodes.size());
+    for (size_t j = 0; j < nodes.size(); ++j) {
+      const NodeId f0 = nodes[j].branch[0];
+      const NodeId f1 = nodes[j].branch[1];
+      const bddp g = bddgetznode(v, work[f0.row()][f0.col()],
+                                 work[f1.row()][f1.col()]);
+      if (g == bddnull) {  // out of the node table
+        for (size_t k = 0; k < work.size(); ++k) {
+          for (size_t l = 0; l < work[k].size(); ++l) bddfree(work[k][l]);
+        }
+        throw std::bad_alloc();
+      }
+      work[i].push_back(g);
+    }
+    const MyVector<int>& levels = diagram.lowerLevels(i);
+    for (const int* t = levels.begin(); t != levels.end(); ++t) {
+      for (size_t j = 0; j < work[*t].size(); ++j) bddfree(work[*t][j]);
+      vector<bddp>().swap(work[*t]);
+    }
+  }
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+  zdd_t f = ZBDD_ID(bddcopy(work[n][root.col()]));
+  for (size_t i = 0; i < work.size(); ++i) {
+    for (size_t j = 0; j < work[i].size(); ++j) bddfree(work[i][j]);
+  }
+  return f;
+}
 
+// This function builds the ZDD of the subsets in search_space, or all the
+// subsets if NULL, that are accepted by the spec.
+template <typename S>
+static zdd_t BuildSubset(const S& spec, const zdd_t* search_space) {
   DdStructure<2> dd;
   if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
+    dd = ExportZdd(*search_space, setset::max_elem() - setset::num_elems());
   } else {
-    dd = DdStructure<2>(g.edgeSize());
+    dd = DdStructure<2>(setset::num_elems());
   }
+  dd.useMultiProcessors(tdzdd::maxThreads() > 1);
 
-  FrontierDirectedSTPathSpec spec(g, is_hamiltonian, g.getVertex(s),
-                                  g.getVertex(t));
   dd.zddSubset(spec);
   dd.zddReduce();
 
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
+  return ImportZdd(dd, setset::max_elem() - setset::num_elems());
 }
 
-setset SearchDirectedForests(const std::vector<edge_t>& digraph,
-                             const std::vector<vertex_t>& roots,
-                             bool is_spanning, const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+// This class builds the ZDD of the subsets in search_space, or all the
+// subsets if NULL, that are accepted by the spec given to it.
+class SubsetBuilder {
+ public:
+  explicit SubsetBuilder(const setset* search_space)
+      : search_space_(search_space) {}
+
+  template <typename S>
+  void operator()(const S& spec) {
+    result_ = setset(BuildSubset(
+        spec, search_space_ != NULL ? &search_space_->zdd_ : NULL));
+  }
+
+  const setset& result() const { return result_; }
+
+ private:
+  const setset* search_space_;
+  setset result_;
+};
+
+// This class estimates the cost of building the ZDD for the spec given to
+// it, whose frontier bounds are set as SetFrontierBounds.
+class SubsetEstimator {
+ public:
+  SubsetEstimator(const UniverseGraph& u, const setset* search_space,
+                  int width_limit, int max_degree, bool has_components)
+      : search_space_(search_space) {
+    estimate_.width_limit = width_limit;
+    SetFrontierBounds(u, max_degree, has_components, &estimate_);
+  }
+
+  template <typename S>
+  void operator()(const S& spec) {
+    EstimateSubset(spec,
+                   search_space_ != NULL ? &search_space_->zdd_ : NULL, true,
+                   &estimate_);
+  }
+
+  SearchEstimate& result() { return estimate_; }
+
+ private:
+  const setset* search_space_;
+  SearchEstimate estimate_;
+};
+
+// The following functions give the spec of each search to f, which is
+// either SubsetBuilder or SubsetEstimator.
+
+template <typename F>
+static void ApplyDirectedCyclesSpec(const UniverseGraph& u, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
+  f(FrontierDirectedSingleCycleSpec(g, u.frontierManager()));
+}
+
+template <typename F>
+static void ApplyDirectedHamiltonianCyclesSpec(const UniverseGraph& u, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
+  f(FrontierDirectedSingleHamiltonianCycleSpec(g, u.frontierManager()));
+}
+
+template <typename F>
+static void ApplyDirectedSTPathSpec(const UniverseGraph& u,
+                                    bool is_hamiltonian, vertex_t s,
+                                    vertex_t t, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
+  f(FrontierDirectedSTPathSpec(g, u.frontierManager(), is_hamiltonian,
+                               g.getVertex(s), g.getVertex(t),
+                               u.reachability(g.getVertex(t), true),
+                               u.reachability(g.getVertex(s), false)));
+}
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+template <typename F>
+static void ApplyDirectedForestsSpec(const UniverseGraph& u,
+                                     const std::vector<vertex_t>& roots,
+                                     bool is_spanning, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
 
   std::set<tdzdd::Digraph::VertexNumber> roots_set;
   for (const auto& root : roots) {
     roots_set.insert(g.getVertex(root));
   }
+  f(FrontierRootedForestSpec(g, u.frontierManager(), roots_set, is_spanning));
+}
 
-  DdStructure<2> dd;
-  if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
-  } else {
-    dd = DdStructure<2>(g.edgeSize());
+template <typename F>
+static void ApplyRootedTreesSpec(const UniverseGraph& u, vertex_t root,
+                                 bool is_spanning, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
+  f(FrontierRootedTreeSpec(g, u.frontierManager(), g.getVertex(root),
+                           is_spanning));
+}
+
+// This function returns a spec of the degree constraints, which are not
+// applied if NULL.
+static FrontierDegreeSpecifiedSpec DegreeSpec(
+    const UniverseGraph& u,
+    const std::map<vertex_t, Range>* in_degree_constraints,
+    const std::map<vertex_t, Range>* out_degree_constraints) {
+  const Digraph& g = u.graph();
+  FrontierDegreeSpecifiedSpec dc(g, u.frontierManager());
+  if (in_degree_constraints != NULL) {
+    for (auto i = in_degree_constraints->begin();
+         i != in_degree_constraints->end(); ++i) {
+      dc.setIndegConstraint(g.getVertex(i->first), i->second);
+    }
   }
+  if (out_degree_constraints != NULL) {
+    for (auto i = out_degree_constraints->begin();
+         i != out_degree_constraints->end(); ++i) {
+      dc.setOutdegConstraint(g.getVertex(i->first), i->second);
+    }
+  }
+  return dc;
+}
 
-  FrontierRootedForestSpec spec(g, roots_set, is_spanning);
-  dd.zddSubset(spec);
-  dd.zddReduce();
+// This function gives the intersection of the spec of the structure and
+// those of the degree and the size constraints of the query to f.
+template <typename S, typename F>
+static void ApplyConstrainedSpec(const UniverseGraph& u, const S& structure,
+                                 const SubgraphQuery& query, F& f) {
+  FrontierDegreeSpecifiedSpec dc = DegreeSpec(
+      u, query.in_degree_constraints, query.out_degree_constraints);
+  SizeConstraint size(u.graph().edgeSize(), query.num_edges);
+  f(zddIntersection(structure, dc, size));
+}
 
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
+template <typename F>
+static void ApplyDirectedSubgraphsSpec(const UniverseGraph& u,
+                                       const SubgraphQuery& query, F& f) {
+  const Digraph& g = u.graph();
+  assert(setset::num_elems() == g.edgeSize());
+  const FrontierManager& fm = u.frontierManager();
+
+  switch (query.structure) {
+    case SubgraphQuery::CYCLE:
+      ApplyConstrainedSpec(u, FrontierDirectedSingleCycleSpec(g, fm), query,
+                           f);
+      break;
+    case SubgraphQuery::HAMILTONIAN_CYCLE:
+      ApplyConstrainedSpec(
+          u, FrontierDirectedSingleHamiltonianCycleSpec(g, fm), query, f);
+      break;
+    case SubgraphQuery::ST_PATH: {
+      const int s = g.getVertex(query.s);
+      const int t = g.getVertex(query.t);
+      ApplyConstrainedSpec(
+          u,
+          FrontierDirectedSTPathSpec(g, fm, query.is_hamiltonian, s, t,
+                                     u.reachability(t, true),
+                                     u.reachability(s, false)),
+          query, f);
+      break;
+    }
+    case SubgraphQuery::FOREST: {
+      std::set<Digraph::VertexNumber> roots_set;
+      for (const auto& root : query.roots) {
+        roots_set.insert(g.getVertex(root));
+      }
+      ApplyConstrainedSpec(
+          u, FrontierRootedForestSpec(g, fm, roots_set, query.is_spanning),
+          query, f);
+      break;
+    }
+    case SubgraphQuery::ROOTED_TREE:
+      ApplyConstrainedSpec(u,
+                           FrontierRootedTreeSpec(g, fm,
+                                                  g.getVertex(query.root),
+                                                  query.is_spanning),
+                           query, f);
+      break;
+    default: {
+      FrontierDegreeSpecifiedSpec dc = DegreeSpec(
+          u, query.in_degree_constraints, query.out_degree_constraints);
+      SizeConstraint size(g.edgeSize(), query.num_edges);
+      f(zddIntersection(dc, size));
+      break;
+    }
+  }
 }
 
-setset SearchRootedTrees(const std::vector<edge_t>& digraph, vertex_t root,
-                         bool is_spanning, const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+static setset SearchDirectedCycles(const UniverseGraph& u,
+                                   const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyDirectedCyclesSpec(u, build);
+  return build.result();
+}
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+static setset SearchDirectedHamiltonianCycles(const UniverseGraph& u,
+                                              const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyDirectedHamiltonianCyclesSpec(u, build);
+  return build.result();
+}
 
-  DdStructure<2> dd;
-  if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
-  } else {
-    dd = DdStructure<2>(g.edgeSize());
+static setset SearchDirectedSTPath(const UniverseGraph& u,
+                                   bool is_hamiltonian, vertex_t s,
+                                   vertex_t t, const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyDirectedSTPathSpec(u, is_hamiltonian, s, t, build);
+  return build.result();
+}
+
+static setset SearchDirectedForests(const UniverseGraph& u,
+                                    const std::vector<vertex_t>& roots,
+                                    bool is_spanning,
+                                    const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyDirectedForestsSpec(u, roots, is_spanning, build);
+  return build.result();
+}
+
+static setset SearchRootedTrees(const UniverseGraph& u, vertex_t root,
+                                bool is_spanning,
+                                const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyRootedTreesSpec(u, root, is_spanning, build);
+  return build.result();
+}
+
+static setset SearchDirectedGraphs(
+    const UniverseGraph& u,
+    const std::map<vertex_t, Range>* in_degree_constraints,
+    const std::map<vertex_t, Range>* out_degree_constraints,
+    const setset* search_space) {
+  assert(setset::num_elems() == u.graph().edgeSize());
+  if (in_degree_constraints == NULL && out_degree_constraints == NULL) {
+    return search_space != NULL ? *search_space : ~setset();
   }
 
-  FrontierRootedTreeSpec spec(g, g.getVertex(root), is_spanning);
-  dd.zddSubset(spec);
-  dd.zddReduce();
+  // in- and out-degrees are checked together in a single pass
+  SubsetBuilder build(search_space);
+  build(DegreeSpec(u, in_degree_constraints, out_degree_constraints));
+  return build.result();
+}
+
+setset SearchDirectedCycles(const std::vector<edge_t>& digraph,
+                            const setset* search_space) {
+  UniverseGraph u(digraph);
+  return SearchDirectedCycles(u, search_space);
+}
+
+setset SearchDirectedCycles(int graph_handle, const setset* search_space) {
+  return SearchDirectedCycles(GetUniverseGraph(graph_handle), search_space);
+}
+
+setset SearchDirectedHamiltonianCycles(const std::vector<edge_t>& digraph,
+                                       const setset* search_space) {
+  UniverseGraph u(digraph);
+  return SearchDirectedHamiltonianCycles(u, search_space);
+}
+
+setset SearchDirectedHamiltonianCycles(int graph_handle,
+                                       const setset* search_space) {
+  return SearchDirectedHamiltonianCycles(GetUniverseGraph(graph_handle),
+                                         search_space);
+}
+
+setset SearchDirectedSTPath(const std::vector<edge_t>& digraph,
+                            bool is_hamiltonian, vertex_t s, vertex_t t,
+                            const setset* search_space) {
+  UniverseGraph u(digraph);
+  return SearchDirectedSTPath(u, is_hamiltonian, s, t, search_space);
+}
+
+setset SearchDirectedSTPath(int graph_handle, bool is_hamiltonian, vertex_t s,
+                            vertex_t t, const setset* search_space) {
+  return SearchDirectedSTPath(GetUniverseGraph(graph_handle), is_hamiltonian,
+                              s, t, search_space);
+}
+
+setset SearchDirectedForests(const std::vector<edge_t>& digraph,
+                             const std::vector<vertex_t>& roots,
+                             bool is_spanning, const setset* search_space) {
+  UniverseGraph u(digraph);
+  return SearchDirectedForests(u, roots, is_spanning, search_space);
+}
+
+setset SearchDirectedForests(int graph_handle,
+                             const std::vector<vertex_t>& roots,
+                             bool is_spanning, const setset* search_space) {
+  return SearchDirectedForests(GetUniverseGraph(graph_handle), roots,
+                               is_spanning, search_space);
+}
+
+setset SearchRootedTrees(const std::vector<edge_t>& digraph, vertex_t root,
+                         bool is_spanning, const setset* search_space) {
+  UniverseGraph u(digraph);
+  return SearchRootedTrees(u, root, is_spanning, search_space);
+}
 
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
+setset SearchRootedTrees(int graph_handle, vertex_t root, bool is_spanning,
+                         const setset* search_space) {
+  return SearchRootedTrees(GetUniverseGraph(graph_handle), root, is_spanning,
+                           search_space);
 }
 
 setset SearchDirectedGraphs(
@@ -190,47 +669,141 @@ setset SearchDirectedGraphs(
     const std::map<vertex_t, Range>* in_degree_constraints,
     const std::map<vertex_t, Range>* out_degree_constraints,
     const setset* search_space) {
-  assert(static_cast<size_t>(setset::num_elems()) == digraph.size());
+  UniverseGraph u(digraph);
+  return SearchDirectedGraphs(u, in_degree_constraints, out_degree_constraints,
+                              search_space);
+}
 
-  Digraph g;
-  for (vector<edge_t>::const_iterator e = digraph.begin(); e != digraph.end();
-       ++e)
-    g.addEdge(e->first, e->second);
-  g.update();
-  assert(static_cast<size_t>(g.edgeSize()) == digraph.size());
+setset SearchDirectedGraphs(
+    int graph_handle, const std::map<vertex_t, Range>* in_degree_constraints,
+    const std::map<vertex_t, Range>* out_degree_constraints,
+    const setset* search_space) {
+  return SearchDirectedGraphs(GetUniverseGraph(graph_handle),
+                              in_degree_constraints, out_degree_constraints,
+                              search_space);
+}
 
-  DdStructure<2> dd;
-  if (search_space != NULL) {
-    SapporoZdd f(search_space->zdd_, setset::max_elem() - setset::num_elems());
-    dd = DdStructure<2>(f);
-  } else {
-    dd = DdStructure<2>(g.edgeSize());
-  }
+setset SearchDirectedSubgraphs(int graph_handle, const SubgraphQuery& query,
+                               const setset* search_space) {
+  SubsetBuilder build(search_space);
+  ApplyDirectedSubgraphsSpec(GetUniverseGraph(graph_handle), query, build);
+  return build.result();
+}
 
-  FrontierDegreeSpecifiedSpec in_dc(g);
-  if (in_degree_constraints != NULL) {
-    for (auto i = in_degree_constraints->begin();
-         i != in_degree_constraints->end(); ++i) {
-      in_dc.setIndegConstraint(g.getVertex(i->first), i->second);
-    }
-    dd.zddSubset(in_dc);
-    dd.zddReduce();
+SearchEstimate EstimateDirectedCycles(int graph_handle,
+                                      const setset* search_space,
+                                      int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  SubsetEstimator estimate(u, search_space, width_limit, 1, true);
+  ApplyDirectedCyclesSpec(u, estimate);
+  return estimate.result();
+}
+
+SearchEstimate EstimateDirectedHamiltonianCycles(int graph_handle,
+                                                 const setset* search_space,
+                                                 int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  SubsetEstimator estimate(u, search_space, width_limit, 1, true);
+  ApplyDirectedHamiltonianCyclesSpec(u, estimate);
+  return estimate.result();
+}
+
+SearchEstimate EstimateDirectedSTPath(int graph_handle, bool is_hamiltonian,
+                                      vertex_t s, vertex_t t,
+                                      const setset* search_space,
+                                      int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  SubsetEstimator estimate(u, search_space, width_limit, 1, true);
+  ApplyDirectedSTPathSpec(u, is_hamiltonian, s, t, estimate);
+  return estimate.result();
+}
+
+SearchEstimate EstimateDirectedForests(int graph_handle,
+                                       const std::vector<vertex_t>& roots,
+                                       bool is_spanning,
+                                       const setset* search_space,
+                                       int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  SubsetEstimator estimate(u, search_space, width_limit, -1, true);
+  ApplyDirectedForestsSpec(u, roots, is_spanning, estimate);
+  return estimate.result();
+}
+
+SearchEstimate EstimateRootedTrees(int graph_handle, vertex_t root,
+                                   bool is_spanning,
+                                   const setset* search_space,
+                                   int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  SubsetEstimator estimate(u, search_space, width_limit, -1, true);
+  ApplyRootedTreesSpec(u, root, is_spanning, estimate);
+  return estimate.result();
+}
+
+SearchEstimate EstimateDirectedGraphs(
+    int graph_handle, const std::map<vertex_t, Range>* in_degree_constraints,
+    const std::map<vertex_t, Range>* out_degree_constraints,
+    const setset* search_space, int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  assert(setset::num_elems() == u.graph().edgeSize());
+  SubsetEstimator estimate(u, search_space, width_limit, -1, false);
+  // nothing is built without the constraints
+  if (in_degree_constraints != NULL || out_degree_constraints != NULL) {
+    estimate(DegreeSpec(u, in_degree_constraints, out_degree_constraints));
   }
+  return estimate.result();
+}
 
-  FrontierDegreeSpecifiedSpec out_dc(g);
-  if (out_degree_constraints != NULL) {
-    for (auto i = out_degree_constraints->begin();
-         i != out_degree_constraints->end(); i++) {
-      out_dc.setOutdegConstraint(g.getVertex(i->first), i->second);
+SearchEstimate EstimateDirectedSubgraphs(int graph_handle,
+                                         const SubgraphQuery& query,
+                                         const setset* search_space,
+                                         int width_limit) {
+  const UniverseGraph& u = GetUniverseGraph(graph_handle);
+  int max_degree = -1;
+  bool has_components = true;
+  switch (query.structure) {
+    case SubgraphQuery::CYCLE:
+    case SubgraphQuery::HAMILTONIAN_CYCLE:
+    case SubgraphQuery::ST_PATH:
+      max_degree = 1;
+      break;
+    case SubgraphQuery::FOREST:
+    case SubgraphQuery::ROOTED_TREE:
+      break;
+    default:
+      has_components = false;
+      break;
+  }
+  SubsetEstimator estimate(u, search_space, width_limit, max_degree,
+                           has_components);
+
+  // the number of the edges taken is also stored in the states
+  if (query.num_edges != NULL) {
+    SearchEstimate& e = estimate.result();
+    e.state_bound = 0;
+    for (int i = 0; i < u.graph().edgeSize(); ++i) {
+      double& bound = e.state_bounds[i];
+      bound *= std::min(i, query.num_edges->upperBound()) + 1.0;
+      bound = std::min(bound, std::ldexp(1.0, std::min(i, 1024)));
+      e.state_bound += bound;
     }
-    dd.zddSubset(out_dc);
-    dd.zddReduce();
   }
 
-  zdd_t f = dd.evaluate(ToZBDD(setset::max_elem() - setset::num_elems()));
-  return setset(f);
+  ApplyDirectedSubgraphsSpec(u, query, estimate);
+  return estimate.result();
 }
 
 bool ShowMessages(bool flag) { return MessageHandler::showMessages(flag); }
 
+int NumThreads() { return tdzdd::maxThreads(); }
+
+int SetNumThreads(int num_threads) {
+  assert(num_threads > 0);
+  int old = tdzdd::maxThreads();
+#ifndef _OPENMP
+  num_threads = 1;
+#endif
+  tdzdd::setMaxThreads(num_threads);
+  return old;
+}
+
 }  // namespace digraphillion
@@ -26,31 +26,184 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "subsetting/util/IntRange.hpp"
 
 namespace digraphillion {
+
+// Parses the digraph of the universe once and caches it together with its
+// frontier manager.  The returned handle can be passed to the searches
+// below instead of the edge list.  Only the most recently registered
+// digraph is kept, so older handles become invalid.
+int RegisterUniverseGraph(const std::vector<edge_t>& digraph);
+
+// Parses a digraph used only by some searches, e.g., an edge list given
+// to a search directly, and returns its handle.  Unlike
+// RegisterUniverseGraph, the registered universe graph and its handle
+// are kept.  The digraph is kept until ReleaseTemporaryGraph is called.
+int RegisterTemporaryGraph(const std::vector<edge_t>& digraph);
+
+void ReleaseTemporaryGraph(int graph_handle);
+
+bool IsRegisteredUniverseGraph(int graph_handle);
+
 setset SearchDirectedCycles(const std::vector<edge_t>& digraph,
                             const setset* search_space);
 
+setset SearchDirectedCycles(int graph_handle, const setset* search_space);
+
 setset SearchDirectedHamiltonianCycles(const std::vector<edge_t>& digraph,
                                        const setset* search_space);
 
+setset SearchDirectedHamiltonianCycles(int graph_handle,
+                                       const setset* search_space);
+
 setset SearchDirectedSTPath(const std::vector<edge_t>& digraph,
                             bool is_hamiltonian, vertex_t s, vertex_t t,
                             const setset* search_space);
 
+setset SearchDirectedSTPath(int graph_handle, bool is_hamiltonian, vertex_t s,
+                            vertex_t t, const setset* search_space);
+
 setset SearchDirectedForests(const std::vector<edge_t>& digraph,
                              const std::vector<vertex_t>& roots,
                              bool is_spanning, const setset* search_space);
 
+setset SearchDirectedForests(int graph_handle,
+                             const std::vector<vertex_t>& roots,
+                             bool is_spanning, const setset* search_space);
+
 setset SearchRootedTrees(const std::vector<edge_t>& digraph, vertex_t root,
                          bool is_spanning, const setset* search_space);
 
+setset SearchRootedTrees(int graph_handle, vertex_t root, bool is_spanning,
+                         const setset* search_space);
+
 setset SearchDirectedGraphs(
     const std::vector<edge_t>& digraph,
     const std::map<vertex_t, tdzdd::Range>* in_degree_constraints,
     const std::map<vertex_t, tdzdd::Range>* out_degree_constraints,
     const setset* search_space);
 
+setset SearchDirectedGraphs(
+    int graph_handle,
+    const std::map<vertex_t, tdzdd::Range>* in_degree_constraints,
+    const std::map<vertex_t, tdzdd::Range>* out_degree_constraints,
+    const setset* search_space);
+
+// A combination of constraints on the subgraphs searched by
+// SearchDirectedSubgraphs.  The specs of the constraints are intersected
+// and evaluated in a single pass, so the DDs of the subgraphs satisfying
+// each constraint are never built.
+struct SubgraphQuery {
+  enum Structure {
+    ANY,                // no structural constraint
+    CYCLE,              // as SearchDirectedCycles
+    HAMILTONIAN_CYCLE,  // as SearchDirectedHamiltonianCycles
+    ST_PATH,            // as SearchDirectedSTPath with s, t, is_hamiltonian
+    FOREST,             // as SearchDirectedForests with roots, is_spanning
+    ROOTED_TREE         // as SearchRootedTrees with root, is_spanning
+  };
+  Structure structure;
+  vertex_t s;
+  vertex_t t;
+  bool is_hamiltonian;
+  std::vector<vertex_t> roots;
+  vertex_t root;
+  bool is_spanning;
+
+  // the degree constraints as SearchDirectedGraphs and the range of the
+  // number of the edges, which are not applied if NULL
+  const std::map<vertex_t, tdzdd::Range>* in_degree_constraints;
+  const std::map<vertex_t, tdzdd::Range>* out_degree_constraints;
+  const tdzdd::Range* num_edges;
+
+  SubgraphQuery()
+      : structure(ANY),
+        is_hamiltonian(false),
+        is_spanning(false),
+        in_degree_constraints(NULL),
+        out_degree_constraints(NULL),
+        num_edges(NULL) {}
+};
+
+setset SearchDirectedSubgraphs(int graph_handle, const SubgraphQuery& query,
+                               const setset* search_space);
+
+// Estimated cost of a search, which is given by the Estimate* functions
+// below without running the search.  The vectors are indexed by the edges
+// in the processing order, i.e., the order of the universe.
+struct SearchEstimate {
+  // the number of the vertices on the frontier
+  int max_frontier_size;
+  std::vector<int> frontier_sizes;
+
+  // upper bounds of the number of the states before each edge is
+  // processed and their sum, which are computed from the frontier sizes;
+  // they do not take search_space into account
+  std::vector<double> state_bounds;
+  double state_bound;
+
+  // the maximum number of the states kept at each level by the sampled
+  // build, which is given by the caller
+  int width_limit;
+
+  // the estimated number of the nodes created by the search, which is
+  // given by the sampled build
+  std::vector<double> node_counts;
+  double nodes;
+
+  // the estimated time in seconds and memory in bytes of the search
+  double seconds;
+  double memory;
+
+  // true if the sampled build has not dropped any state, in which case
+  // node_counts are exact
+  bool exact;
+};
+
+SearchEstimate EstimateDirectedCycles(int graph_handle,
+                                      const setset* search_space,
+                                      int width_limit);
+
+SearchEstimate EstimateDirectedHamiltonianCycles(int graph_handle,
+                                                 const setset* search_space,
+                                                 int width_limit);
+
+SearchEstimate EstimateDirectedSTPath(int graph_handle, bool is_hamiltonian,
+                                      vertex_t s, vertex_t t,
+                                      const setset* search_space,
+                                      int width_limit);
+
+SearchEstimate EstimateDirectedForests(int graph_handle,
+                                       const std::vector<vertex_t>& roots,
+                                       bool is_spanning,
+                                       const setset* search_space,
+                                       int width_limit);
+
+SearchEstimate EstimateRootedTrees(int graph_handle, vertex_t root,
+                                   bool is_spanning,
+                                   const setset* search_space,
+                                   int width_limit);
+
+SearchEstimate EstimateDirectedGraphs(
+    int graph_handle,
+    const std::map<vertex_t, tdzdd::Range>* in_degree_constraints,
+    const std::map<vertex_t, tdzdd::Range>* out_degree_constraints,
+    const setset* search_space, int width_limit);
+
+SearchEstimate EstimateDirectedSubgraphs(int graph_handle,
+                                         const SubgraphQuery& query,
+                                         const setset* search_space,
+                                         int width_limit);
+
 bool ShowMessages(bool flag = true);
 
+int NumThreads();
+
+// Sets the number of threads used by the searches above and by the
+// counting of setsets, and returns the previous setting.  num_threads must
+// be positive.  The threads are given to the parallel regions of the
+// library only, and the OpenMP setting of the process is left unchanged.
+// Without OpenMP support, a single thread is always used.
+int SetNumThreads(int num_threads);
+
 }  // namespace digraphillion
 
 #endif  // DIGRAPHILLION_GRAPHSET_H_
@@ -22,10 +22,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "digraphillion/setset.h"
 
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
 
 #include "digraphillion/zdd.h"
-#include "subsetting/dd/PathCounter.hpp"
-#include "subsetting/spec/SapporoZdd.hpp"
 
 namespace digraphillion {
 
@@ -35,7 +35,6 @@ using std::map;
 using std::ostream;
 using std::pair;
 using std::set;
-using std::sort;
 using std::string;
 using std::vector;
 
@@ -44,11 +43,14 @@ using std::vector;
 setset::iterator::iterator() : zdd_(null()), s_(set<elem_t>()) {}
 
 setset::iterator::iterator(const setset::iterator& i)
-    : zdd_(i.zdd_), s_(i.s_) {}
+    : zdd_(i.zdd_), s_(i.s_), path_(i.path_) {}
 
 setset::iterator::iterator(const setset& ss)
     : zdd_(ss.zdd_), s_(set<elem_t>()) {
-  this->next();
+  if (this->zdd_ == bot())
+    this->zdd_ = null();
+  else
+    this->descend(digraphillion::id(this->zdd_));
 }
 
 setset::iterator::iterator(const setset& ss, const set<elem_t>& s)
@@ -59,68 +61,123 @@ setset::iterator& setset::iterator::operator++() {
   return *this;
 }
 
+size_t setset::iterator::next_n(size_t k, vector<set<elem_t> >* v) {
+  assert(v != NULL);
+  size_t n = 0;
+  for (; n < k && this->zdd_ != null(); ++n) {
+    v->push_back(this->s_);
+    this->next();
+  }
+  return n;
+}
+
+// The sets are visited in the depth-first order taking hi() before lo(),
+// so the next set is found by backtracking to the last hi() branch on
+// path_ and descending from its lo() child.  Each edge of the path is
+// pushed and popped only once over the iteration.
 void setset::iterator::next() {
   if (this->zdd_ == null() || this->zdd_ == bot()) {
     this->zdd_ = null();
     this->s_ = set<elem_t>();
-  } else {
-    vector<elem_t> stack(this->s_.begin(), this->s_.end());
-    sort(stack.begin(), stack.end());
-    bool res = choose(this->zdd_, &stack);
-    if (res) {
-      this->s_ = set<elem_t>(stack.begin(), stack.end());
-      if (stack.size() == 0)  // reach to the empty set (the last)
-        this->zdd_ = bot();
-    } else {
-      this->zdd_ = null();
+    this->path_.clear();
+    return;
+  }
+  if (this->path_.empty() && !is_term(this->zdd_)) this->locate();
+  while (!this->path_.empty()) {
+    word_t f = this->path_.back().first;
+    bool is_hi = this->path_.back().second;
+    this->path_.pop_back();
+    if (!is_hi) continue;
+    this->s_.erase(static_cast<elem_t>(bddtop(f)));
+    word_t l = bddgetzchild(f, 0);
+    if (l != bddempty) {
+      this->path_.push_back(make_pair(f, false));
+      this->descend(l);
+      return;
     }
   }
+  this->zdd_ = null();
+  this->s_ = set<elem_t>();
+}
+
+// This function descends from node f by hi() to the first set under it,
+// which ends at top() since hi() of a node is never bot().
+void setset::iterator::descend(word_t f) {
+  while (f != bddempty && f != bddsingle) {
+    this->path_.push_back(make_pair(f, true));
+    this->s_.insert(static_cast<elem_t>(bddtop(f)));
+    f = bddgetzchild(f, 1);
+  }
+}
+
+// This function rebuilds path_ for s_, which is given by the constructor
+// instead of the iteration.
+void setset::iterator::locate() {
+  word_t f = digraphillion::id(this->zdd_);
+  while (f != bddempty && f != bddsingle) {
+    elem_t v = static_cast<elem_t>(bddtop(f));
+    bool is_hi = this->s_.find(v) != this->s_.end();
+    this->path_.push_back(make_pair(f, is_hi));
+    f = bddgetzchild(f, is_hi ? 1 : 0);
+  }
 }
 
-setset::random_iterator::random_iterator() : iterator(), size_(0) {}
+setset::random_iterator::random_iterator() : iterator() {}
 
 setset::random_iterator::random_iterator(const setset::random_iterator& i)
-    : iterator(i), size_(i.size_) {}
+    : iterator(i), sampler_(i.sampler_) {}
 
 setset::random_iterator::random_iterator(const setset& ss)
-    : iterator(ss, set<elem_t>()) {
-  this->size_ = algo_c(ss.zdd_);
+    : iterator(ss, set<elem_t>()), sampler_(new zdd_sampler(ss.zdd_)) {
   this->next();
 }
 
 void setset::random_iterator::next() {
-  if (this->zdd_ == null() || this->zdd_ == bot()) {
+  vector<elem_t> s;
+  if (this->zdd_ == null()) {
+    this->s_ = set<elem_t>();
+    return;
+  }
+  // Since same sets are rarely selected from very large setset that has more
+  // than 1e17 sets, we don't need to remove the selected sets
+  bool replace = this->sampler_->size() >= 1e17;
+  // a copy takes its own sampler before removing a set, so the copies
+  // never remove the sets of each other
+  if (!replace && this->sampler_.use_count() > 1)
+    this->sampler_.reset(new zdd_sampler(*this->sampler_));
+  if (!this->sampler_->draw(replace, &s)) {
     this->zdd_ = null();
     this->s_ = set<elem_t>();
   } else {
-    vector<elem_t> stack;
-    zdd_t z = choose_random(this->zdd_, &stack);
-    // Since same sets are rarely selected from very large setset that has more
-    // than 1e17 sets, we don't need to remove the selected sets
-    if (this->size_ < 1e17) this->zdd_ -= z;
-    this->s_ = set<elem_t>(stack.begin(), stack.end());
+    this->s_ = set<elem_t>(s.begin(), s.end());
   }
 }
 
 setset::weighted_iterator::weighted_iterator() : iterator() {}
 
 setset::weighted_iterator::weighted_iterator(const setset::weighted_iterator& i)
-    : iterator(i), weights_(i.weights_) {}
+    : iterator(i), kbest_(i.kbest_) {}
 
 setset::weighted_iterator::weighted_iterator(const setset& ss,
                                              vector<double> weights)
-    : iterator(ss, set<elem_t>()), weights_(weights) {
+    : iterator(ss, set<elem_t>()), kbest_(new zdd_kbest(ss.zdd_, weights)) {
   this->next();
 }
 
 void setset::weighted_iterator::next() {
-  if (this->zdd_ == null() || this->zdd_ == bot()) {
+  vector<elem_t> s;
+  if (this->zdd_ == null()) {
+    this->s_ = set<elem_t>();
+    return;
+  }
+  // a copy takes its own enumerator before advancing it
+  if (this->kbest_.use_count() > 1)
+    this->kbest_.reset(new zdd_kbest(*this->kbest_));
+  if (!this->kbest_->next(&s)) {
     this->zdd_ = null();
     this->s_ = set<elem_t>();
   } else {
-    set<elem_t> s;
-    this->zdd_ -= choose_best(this->zdd_, this->weights_, &s);
-    this->s_ = s;
+    this->s_ = set<elem_t>(s.begin(), s.end());
   }
 }
 
@@ -147,18 +204,23 @@ setset::setset(const map<string, vector<elem_t> >& m) {
     single(*e);
   for (vector<elem_t>::const_iterator e = ex_v.begin(); e != ex_v.end(); ++e)
     single(*e);
-  vector<zdd_t> n(num_elems() + 2);
-  n[0] = bot(), n[1] = top();
+  if (in_v.empty() && ex_v.empty()) {
+    this->zdd_ = universe();
+    return;
+  }
+  set<elem_t> in_s(in_v.begin(), in_v.end());
+  set<elem_t> ex_s(ex_v.begin(), ex_v.end());
+  zdd_t f = top();
   for (elem_t v = num_elems(); v > 0; --v) {
-    bool in_found = std::find(in_v.begin(), in_v.end(), v) != in_v.end();
-    bool ex_found = std::find(ex_v.begin(), ex_v.end(), v) != ex_v.end();
+    bool in_found = in_s.find(v) != in_s.end();
+    bool ex_found = ex_s.find(v) != ex_s.end();
     assert(!(in_found && ex_found));
-    elem_t i = num_elems() - v + 2;
-    n[i] = in_found   ? n[0] + single(v) * n[i - 1]
-           : ex_found ? n[i - 1] + single(v) * n[0]
-                      : n[i - 1] + single(v) * n[i - 1];
+    if (in_found)
+      f = ZBDD_Node(v, bot(), f);
+    else if (!ex_found)
+      f = ZBDD_Node(v, f, f);
   }
-  this->zdd_ = n[num_elems() + 1];
+  this->zdd_ = f;
 }
 
 setset::setset(istream& in) : zdd_(digraphillion::load(in)) {}
@@ -233,10 +295,17 @@ bool setset::is_superset(const setset& ss) const { return *this >= ss; }
 
 bool setset::empty() const { return this->zdd_ == bot(); }
 
+// The counts of the nodes are kept by bddcardmp10 until they are freed, so
+// the sets are counted again only if they exceed its multi-word integers.
 string setset::size() const {
-  tdzdd::SapporoZdd f(this->zdd_,
-                      digraphillion::max_elem() - digraphillion::num_elems());
-  return countPaths(f, true);
+  char* c = bddcardmp10(digraphillion::id(this->zdd_), NULL);
+  if (c != NULL && *c != '\0') {
+    string s(c);
+    free(c);
+    return s;
+  }
+  free(c);
+  return digraphillion::count(this->zdd_);
 }
 
 setset::iterator setset::begin() const { return setset::iterator(*this); }
@@ -338,17 +407,29 @@ setset setset::hitting() const {  // a.k.a cross elements
   return setset(digraphillion::hitting(this->zdd_));
 }
 
+// The sizes are given by size_window in a single pass, where they are
+// limited to INT_MAX, which is larger than any set.
 setset setset::smaller(size_t set_size) const {
-  return setset(this->zdd_.PermitSym(set_size - 1));
+  if (set_size == 0) return setset();
+  int upper = static_cast<int>(std::min<size_t>(set_size - 1, INT_MAX));
+  return setset(size_window(this->zdd_, 0, upper));
 }
 
 setset setset::larger(size_t set_size) const {
-  return setset(this->zdd_ - this->zdd_.PermitSym(set_size));
+  if (set_size >= INT_MAX) return setset();
+  return setset(size_window(this->zdd_, set_size + 1, INT_MAX));
 }
 
 setset setset::set_size(size_t set_size) const {
-  zdd_t z = this->zdd_.PermitSym(set_size) - this->zdd_.PermitSym(set_size - 1);
-  return setset(z);
+  if (set_size > INT_MAX) return setset();
+  int size = static_cast<int>(set_size);
+  return setset(size_window(this->zdd_, size, size));
+}
+
+vector<string> setset::size_histogram() const {
+  vector<string> counts;
+  digraphillion::size_histogram(this->zdd_, &counts);
+  return counts;
 }
 
 setset setset::join(const setset& ss) const {
@@ -398,13 +479,27 @@ double setset::probability(const vector<double>& probabilities) const {
     for (int e = 1; e <= num_elems(); ++e) p *= 1 - probabilities[e];
     return p;
   } else {
-    map<word_t, double> cache;
-    cache[digraphillion::id(bot())] = 0;
-    cache[digraphillion::id(top())] = 1;
-    return digraphillion::probability(1, this->zdd_, probabilities, cache);
+    return digraphillion::probability(this->zdd_, probabilities);
   }
 }
 
+vector<double> setset::probabilities(
+    const vector<vector<double> >& probabilities) const {
+  vector<double> results;
+  digraphillion::probabilities(this->zdd_, probabilities, &results);
+  return results;
+}
+
+size_t setset::sample(size_t n, bool replace, vector<set<elem_t> >* v) const {
+  assert(v != NULL);
+  zdd_sampler sampler(this->zdd_);
+  vector<elem_t> s;
+  size_t i = 0;
+  for (; i < n && sampler.draw(replace, &s); ++i)
+    v->push_back(set<elem_t>(s.begin(), s.end()));
+  return i;
+}
+
 void setset::dump(ostream& out) const { digraphillion::dump(this->zdd_, out); }
 
 void setset::dump(FILE* fp) const { digraphillion::dump(this->zdd_, fp); }
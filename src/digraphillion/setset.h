@@ -25,6 +25,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -34,6 +35,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "subsetting/util/IntRange.hpp"
 
 namespace digraphillion {
+
+class zdd_kbest;
+class zdd_sampler;
+
 class setset {
  public:
   class iterator
@@ -51,11 +56,23 @@ class setset {
     std::set<elem_t>& operator*() { return this->s_; }
     iterator& operator++();
 
+    // This function appends the current set and the following ones to v,
+    // k sets at most, and returns the number of the appended sets.
+    size_t next_n(size_t k, std::vector<std::set<elem_t> >* v);
+
    protected:
     virtual void next();
 
     zdd_t zdd_;
     std::set<elem_t> s_;
+
+   private:
+    void descend(word_t f);
+    void locate();
+
+    // the nodes on the path to the current set from the root of zdd_,
+    // each with the branch taken; the nodes are referred by zdd_
+    std::vector<std::pair<word_t, bool> > path_;
   };
 
   typedef iterator const_iterator;
@@ -71,7 +88,10 @@ class setset {
    protected:
     virtual void next();
 
-    double size_;
+    // shared by the copies until one of them removes a drawn set, so each
+    // copy draws from its own remaining sets; the random numbers come from
+    // rand_xor128() of the process as before
+    std::shared_ptr<zdd_sampler> sampler_;
   };
 
   class weighted_iterator : public iterator {
@@ -85,7 +105,9 @@ class setset {
    protected:
     virtual void next();
 
-    std::vector<double> weights_;
+    // shared by the copies until one of them advances, so each copy
+    // enumerates the rest of the sequence by itself
+    std::shared_ptr<zdd_kbest> kbest_;
   };
 
   setset();
@@ -148,6 +170,9 @@ class setset {
   setset smaller(size_t set_size) const;
   setset larger(size_t set_size) const;
   setset set_size(size_t set_size) const;
+  // This function returns the numbers of the sets indexed by their sizes,
+  // which are counted in a single pass.
+  std::vector<std::string> size_histogram() const;
 
   setset join(const setset& ss) const;
   setset meet(const setset& ss) const;
@@ -159,6 +184,16 @@ class setset {
   setset non_supersets(elem_t e) const;
 
   double probability(const std::vector<double>& probabilities) const;
+  // This function returns the probabilities for many vectors of element
+  // probabilities at once, sharing one pass over the nodes.
+  std::vector<double> probabilities(
+      const std::vector<std::vector<double> >& probabilities) const;
+
+  // This function appends n sets drawn uniformly at random to v, fewer if
+  // replace is false and less than n sets are left, and returns the
+  // number of the appended sets.
+  size_t sample(size_t n, bool replace,
+                std::vector<std::set<elem_t> >* v) const;
 
   void dump(std::ostream& out) const;
   void dump(FILE* fp = stdout) const;
@@ -211,6 +246,9 @@ class setset {
       const std::map<vertex_t, tdzdd::Range>* in_degree_constraints,
       const std::map<vertex_t, tdzdd::Range>* out_degree_constraints,
       const setset* search_space);
+
+  friend class SubsetBuilder;
+  friend class SubsetEstimator;
 };
 
 }  // namespace digraphillion
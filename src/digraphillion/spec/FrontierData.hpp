@@ -23,6 +23,10 @@ SOFTWARE.
 #ifndef DIGRAPHILLION_FRONTIER_DATA_HPP_
 #define DIGRAPHILLION_FRONTIER_DATA_HPP_
 
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
 // data associated with each vertex on the frontier
 class DirectedFrontierData {
  public:
@@ -31,4 +35,107 @@ class DirectedFrontierData {
   short comp;
 };
 
+// Bit-packed layout of the data associated with each vertex on the
+// frontier, used by the specs in which both indeg and outdeg of every
+// vertex are at most one (cycles and paths).
+// Each position on the frontier occupies one bit for indeg, one bit for
+// outdeg and comp_bits bits for comp. The entries are packed into 64-bit
+// words so that no entry straddles two words.
+class PackedDirectedFrontierLayout {
+ public:
+  typedef uint64_t Word;
+
+ private:
+  int num_words_;
+  int entries_per_word_;
+  Word comp_mask_;
+  // word index and bit offset of the entry of each position
+  std::vector<int> word_of_pos_;
+  std::vector<int> shift_of_pos_;
+
+  Word& entry(Word* data, int pos, int* shift) const {
+    *shift = shift_of_pos_[pos];
+    return data[word_of_pos_[pos]];
+  }
+
+  Word entry(const Word* data, int pos) const {
+    return data[word_of_pos_[pos]] >> shift_of_pos_[pos];
+  }
+
+ public:
+  // frontier_size: the number of positions on the frontier
+  // max_comp: the maximum value stored in comp
+  PackedDirectedFrontierLayout(int frontier_size, int max_comp)
+      : word_of_pos_(frontier_size), shift_of_pos_(frontier_size) {
+    int comp_bits = 1;
+    while ((1 << comp_bits) <= max_comp) {
+      ++comp_bits;
+    }
+    comp_mask_ = (Word(1) << comp_bits) - 1;
+    const int entry_bits = 2 + comp_bits;
+    entries_per_word_ = 64 / entry_bits;
+    for (int pos = 0; pos < frontier_size; ++pos) {
+      word_of_pos_[pos] = pos / entries_per_word_;
+      shift_of_pos_[pos] = (pos % entries_per_word_) * entry_bits;
+    }
+    num_words_ = numWords(frontier_size);
+  }
+
+  // This function returns the number of words of a state.
+  int numWords() const { return num_words_; }
+
+  // This function returns the number of words storing the first
+  // (num_positions) positions.
+  int numWords(int num_positions) const {
+    return (num_positions + entries_per_word_ - 1) / entries_per_word_;
+  }
+
+  short getIndeg(const Word* data, int pos) const {
+    return static_cast<short>(entry(data, pos) & 1);
+  }
+
+  short getOutdeg(const Word* data, int pos) const {
+    return static_cast<short>((entry(data, pos) >> 1) & 1);
+  }
+
+  short getComp(const Word* data, int pos) const {
+    return static_cast<short>((entry(data, pos) >> 2) & comp_mask_);
+  }
+
+  void setIndeg(Word* data, int pos, short d) const {
+    assert(0 <= d && d <= 1);
+    int shift;
+    Word& w = entry(data, pos, &shift);
+    w = (w & ~(Word(1) << shift)) | (Word(d) << shift);
+  }
+
+  void setOutdeg(Word* data, int pos, short d) const {
+    assert(0 <= d && d <= 1);
+    int shift;
+    Word& w = entry(data, pos, &shift);
+    w = (w & ~(Word(1) << (shift + 1))) | (Word(d) << (shift + 1));
+  }
+
+  void setComp(Word* data, int pos, short c) const {
+    assert(0 <= c && static_cast<Word>(c) <= comp_mask_);
+    int shift;
+    Word& w = entry(data, pos, &shift);
+    w = (w & ~(comp_mask_ << (shift + 2))) | (Word(c) << (shift + 2));
+  }
+
+  // This function sets indeg, outdeg and comp of pos to be zero.
+  void clear(Word* data, int pos) const {
+    int shift;
+    Word& w = entry(data, pos, &shift);
+    w &= ~(((comp_mask_ << 2) | 3) << shift);
+  }
+
+  // This function sets all the entries to be zero.
+  void clearAll(Word* data) const {
+    for (int i = 0; i < num_words_; ++i) {
+      data[i] = 0;
+    }
+  }
+};
+
 #endif
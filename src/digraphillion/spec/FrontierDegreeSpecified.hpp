@@ -45,11 +45,17 @@ class FrontierDegreeSpecifiedSpec
   // number of edges
   const int m_;
 
-  const FrontierManager fm_;
+  // frontier manager shared by the specs built on graph_
+  const FrontierManager& fm_;
 
   std::vector<tdzdd::Range> in_constraints;
   std::vector<tdzdd::Range> out_constraints;
 
+  // Only the degrees with constraints are counted, so that the states do
+  // not differ in the degrees that are not cared.
+  std::vector<bool> in_constrained;
+  std::vector<bool> out_constrained;
+
   // This function gets deg of v.
   short getIndeg(DirectedFrontierData* data, short v) const {
     return data[fm_.vertexToPos(v)].indeg;
@@ -77,11 +83,12 @@ class FrontierDegreeSpecifiedSpec
   }
 
  public:
-  FrontierDegreeSpecifiedSpec(const tdzdd::Digraph& graph)
+  FrontierDegreeSpecifiedSpec(const tdzdd::Digraph& graph,
+                              const FrontierManager& fm)
       : graph_(graph),
         n_(static_cast<short>(graph_.vertexSize())),
         m_(graph_.edgeSize()),
-        fm_(graph_) {
+        fm_(fm) {
     if (graph_.vertexSize() > SHRT_MAX) {  // SHRT_MAX == 32767
       std::cerr << "The number of vertices should be at most " << SHRT_MAX
                 << std::endl;
@@ -91,9 +98,12 @@ class FrontierDegreeSpecifiedSpec
     // todo: check all the degrees is at most 256
 
     setArraySize(fm_.getMaxFrontierSize());
+    setLevelArraySizes(fm_.getStateWidthsByLevel());
     int m = graph_.vertexSize();
     in_constraints.resize(m + 1);
     out_constraints.resize(m + 1);
+    in_constrained.assign(m + 1, false);
+    out_constrained.assign(m + 1, false);
     for (int v = 1; v <= m; v++) {
       in_constraints.at(v) = tdzdd::Range(0, INT_MAX);
       out_constraints.at(v) = tdzdd::Range(0, INT_MAX);
@@ -104,12 +114,14 @@ class FrontierDegreeSpecifiedSpec
     if (v < 1 || graph_.vertexSize() < v)
       throw std::runtime_error("ERROR: Vertex number is out of range");
     in_constraints.at(v) = c;
+    in_constrained.at(v) = true;
   }
 
   void setOutdegConstraint(Digraph::VertexNumber v, const tdzdd::Range& c) {
     if (v < 1 || graph_.vertexSize() < v)
       throw std::runtime_error("ERROR: Vertex number is out of range");
     out_constraints.at(v) = c;
+    out_constrained.at(v) = true;
   }
 
   int getRoot(DirectedFrontierData* data) const {
@@ -127,7 +139,7 @@ class FrontierDegreeSpecifiedSpec
     const Digraph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
 
     // initialize deg of the vertices newly entering the frontier
-    const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+    const VertexList entering_vs = fm_.getEnteringVs(edge_index);
     for (size_t i = 0; i < entering_vs.size(); ++i) {
       int v = entering_vs.at(i);
       // initially the value of deg is 0
@@ -148,12 +160,12 @@ class FrontierDegreeSpecifiedSpec
       if (!in_constraints.at(edge.v2).contains(indeg2 + 1)) {
         return 0;
       }
-      setIndeg(data, edge.v2, indeg2 + 1);
-      setOutdeg(data, edge.v1, outdeg1 + 1);
+      if (in_constrained[edge.v2]) setIndeg(data, edge.v2, indeg2 + 1);
+      if (out_constrained[edge.v1]) setOutdeg(data, edge.v1, outdeg1 + 1);
     }
 
     // vertices that are leaving the frontier
-    const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+    const VertexList leaving_vs = fm_.getLeavingVs(edge_index);
     for (size_t i = 0; i < leaving_vs.size(); ++i) {
       int v = leaving_vs.at(i);
 
@@ -23,11 +23,13 @@ SOFTWARE.
 #ifndef FRONTIER_ST_PATH_HPP
 #define FRONTIER_ST_PATH_HPP
 
+#include <algorithm>
 #include <climits>
 #include <vector>
 
 #include "FrontierData.hpp"
 #include "FrontierManager.hpp"
+#include "FrontierReachability.hpp"
 #include "subsetting/DdSpec.hpp"
 #include "subsetting/util/Digraph.hpp"
 
@@ -35,8 +37,10 @@ using namespace tdzdd;
 
 class FrontierDirectedSTPathSpec
     : public tdzdd::PodArrayDdSpec<FrontierDirectedSTPathSpec,
-                                   DirectedFrontierData, 2> {
+                                   PackedDirectedFrontierLayout::Word, 2> {
  private:
+  typedef PackedDirectedFrontierLayout::Word Word;
+
   // input graph
   const tdzdd::Digraph& graph_;
   // number of vertices
@@ -50,46 +54,163 @@ class FrontierDirectedSTPathSpec
   const short s_;
   const short t_;
 
-  const FrontierManager fm_;
+  // frontier manager shared by the specs built on graph_
+  const FrontierManager& fm_;
+  // frontier lists of the edge being processed, rebuilt from fm_
+  mutable FrontierCursor cursor_;
+  // packed layout of the states
+  const PackedDirectedFrontierLayout layout_;
 
   const int s_entered_level_;
   const int t_entered_level_;
   const int min_entered_level_;
 
+  // reachability to t and from s through the unprocessed edges, which
+  // is shared by the specs for the same s and t
+  const FrontierReachability& to_t_;
+  const FrontierReachability& from_s_;
+
   // This function gets deg of v.
-  short getIndeg(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].indeg;
+  short getIndeg(Word* data, short v) const {
+    return layout_.getIndeg(data, fm_.vertexToPos(v));
   }
 
-  short getOutdeg(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].outdeg;
+  short getOutdeg(Word* data, short v) const {
+    return layout_.getOutdeg(data, fm_.vertexToPos(v));
   }
 
   // This function sets deg of v to be d.
-  void setIndeg(DirectedFrontierData* data, short v, short d) const {
-    data[fm_.vertexToPos(v)].indeg = d;
+  void setIndeg(Word* data, short v, short d) const {
+    layout_.setIndeg(data, fm_.vertexToPos(v), d);
   }
 
-  void setOutdeg(DirectedFrontierData* data, short v, short d) const {
-    data[fm_.vertexToPos(v)].outdeg = d;
+  void setOutdeg(Word* data, short v, short d) const {
+    layout_.setOutdeg(data, fm_.vertexToPos(v), d);
   }
 
   // This function gets comp of v.
-  short getComp(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].comp;
+  short getComp(Word* data, short v) const {
+    return layout_.getComp(data, fm_.vertexToPos(v));
   }
 
   // This function sets comp of v to be c.
-  void setComp(DirectedFrontierData* data, short v, short c) const {
-    data[fm_.vertexToPos(v)].comp = c;
+  void setComp(Word* data, short v, short c) const {
+    layout_.setComp(data, fm_.vertexToPos(v), c);
+  }
+
+  // This function renumbers comp of the vertices remaining on the frontier
+  // after the (edge_index)-th edge is processed (see
+  // FrontierManager::normalizeComp).
+  void normalizeComp(Word* data, int edge_index) const {
+    fm_.normalizeComp(
+        cursor_.getRemainingVs(edge_index),
+        [&](int v) { return getComp(data, v); },
+        [&](int v, int c) { setComp(data, v, static_cast<short>(c)); });
   }
 
-  void initializeDegComp(DirectedFrontierData* data) const {
-    for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
-      data[i].indeg = 0;
-      data[i].outdeg = 0;
-      data[i].comp = 0;
+  void initializeDegComp(Word* data) const { layout_.clearAll(data); }
+
+  // This function returns false if some open end of the path fragments
+  // on the frontier after the (edge_index)-th edge is processed cannot be
+  // linked to the rest of the path.  If forward is true, each fragment
+  // head, i.e., s or a vertex of outdeg 0 and indeg 1, must reach t
+  // through the unprocessed edges, where entering the tail of another
+  // fragment leads to its head.  If forward is false, the same holds for
+  // the tails on the reversed edges from s.
+  bool isLinkable(Word* data, int edge_index, bool forward) const {
+    typedef FrontierReachability::Mask Mask;
+    const FrontierReachability& reach = forward ? to_t_ : from_s_;
+    const short source = forward ? s_ : t_;
+    const short target = forward ? t_ : s_;
+
+    // A stuck vertex cannot be extended.
+    const VertexList stuck_vs = reach.getStuckVs(edge_index);
+    for (size_t i = 0; i < stuck_vs.size(); ++i) {
+      const int v = stuck_vs[i];
+      const short out = forward ? getOutdeg(data, v) : getIndeg(data, v);
+      const short in = forward ? getIndeg(data, v) : getOutdeg(data, v);
+      if (v != target && out == 0 && (in == 1 || v == source)) return false;
+    }
+
+    switch (reach.getTriviality(edge_index)) {
+      case FrontierReachability::ALWAYS:
+        return true;
+      case FrontierReachability::IF_TARGET_OPEN:
+        if ((forward ? getIndeg(data, target) : getOutdeg(data, target)) == 0) {
+          return true;
+        }
+        break;
+      default:
+        break;
+    }
+    const VertexList vs = cursor_.getRemainingVs(edge_index);
+
+    // the open end (outdeg 0 if forward) of the fragment of each comp
+    short end_of[64];
+    std::fill(end_of, end_of + fm_.getMaxFrontierSize(), -1);
+    for (size_t i = 0; i < vs.size(); ++i) {
+      const int v = vs[i];
+      const short out = forward ? getOutdeg(data, v) : getIndeg(data, v);
+      const short in = forward ? getIndeg(data, v) : getOutdeg(data, v);
+      if (out == 0 && in == 1) end_of[getComp(data, v)] = fm_.vertexToPos(v);
+    }
+
+    // the vertices at which the path can enter and then reach target
+    Mask good = 0;
+    const bool target_entered =
+        fm_.getVerticesEnteringLevel(target) <= edge_index;
+    const Mask to_target =
+        target_entered ? 0 : reach.reachingTarget(edge_index);
+    int target_pos = -1;
+    for (size_t i = 0; i < vs.size(); ++i) {
+      const int v = vs[i];
+      if (v != target) continue;
+      target_pos = fm_.vertexToPos(v);
+      const short in = forward ? getIndeg(data, v) : getOutdeg(data, v);
+      if (in == 0) good |= static_cast<Mask>(1) << target_pos;
+    }
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (size_t i = 0; i < vs.size(); ++i) {
+        const int v = vs[i];
+        const int p = fm_.vertexToPos(v);
+        const Mask b = static_cast<Mask>(1) << p;
+        if ((good & b) || v == source || v == target) continue;
+        const short out = forward ? getOutdeg(data, v) : getIndeg(data, v);
+        const short in = forward ? getIndeg(data, v) : getOutdeg(data, v);
+        if (in != 0) continue;
+        // v itself if it is isolated, or the head of its fragment
+        int q = p;
+        if (out == 1) {
+          q = end_of[getComp(data, v)];
+          // The fragment ends at target, which may have left the frontier.
+          if (q < 0 || q == target_pos) {
+            good |= b;
+            changed = true;
+            continue;
+          }
+        }
+        if ((to_target & (static_cast<Mask>(1) << q)) ||
+            (reach.reachable(edge_index, q) & good)) {
+          good |= b;
+          changed = true;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < vs.size(); ++i) {
+      const int v = vs[i];
+      const short out = forward ? getOutdeg(data, v) : getIndeg(data, v);
+      const short in = forward ? getIndeg(data, v) : getOutdeg(data, v);
+      if (v == target || out != 0 || (in == 0 && v != source)) continue;
+      const int p = fm_.vertexToPos(v);
+      if (!(to_target & (static_cast<Mask>(1) << p)) &&
+          !(reach.reachable(edge_index, p) & good)) {
+        return false;
+      }
     }
+    return true;
   }
 
   int computeEnteredLevel(short v) const {
@@ -97,32 +218,46 @@ class FrontierDirectedSTPathSpec
   }
 
  public:
-  FrontierDirectedSTPathSpec(const tdzdd::Digraph& graph, bool isHamiltonian,
-                             short s, short t)
+  // to_t and from_s must be FrontierReachability(graph, fm, t, true) and
+  // FrontierReachability(graph, fm, s, false), which outlive the spec.
+  FrontierDirectedSTPathSpec(const tdzdd::Digraph& graph,
+                             const FrontierManager& fm, bool isHamiltonian,
+                             short s, short t,
+                             const FrontierReachability& to_t,
+                             const FrontierReachability& from_s)
       : graph_(graph),
         n_(static_cast<short>(graph_.vertexSize())),
         m_(graph_.edgeSize()),
         isHamiltonian_(isHamiltonian),
         s_(s),
         t_(t),
-        fm_(graph_),
+        fm_(fm),
+        cursor_(fm),
+        layout_(fm_.getMaxFrontierSize(), fm_.getMaxComp()),
         s_entered_level_(computeEnteredLevel(s)),
         t_entered_level_(computeEnteredLevel(t)),
-        min_entered_level_(m_ - fm_.getAllVerticesEnteringLevel()) {
+        min_entered_level_(m_ - fm_.getAllVerticesEnteringLevel()),
+        to_t_(to_t),
+        from_s_(from_s) {
     if (graph_.vertexSize() > SHRT_MAX) {  // SHRT_MAX == 32767
       std::cerr << "The number of vertices should be at most " << SHRT_MAX
                 << std::endl;
       exit(1);
     }
-    setArraySize(fm_.getMaxFrontierSize());
+    setArraySize(layout_.numWords());
+    std::vector<int> level_sizes = fm_.getStateWidthsByLevel();
+    for (size_t i = 0; i < level_sizes.size(); ++i) {
+      level_sizes[i] = layout_.numWords(level_sizes[i]);
+    }
+    setLevelArraySizes(level_sizes);
   }
 
-  int getRoot(DirectedFrontierData* data) const {
+  int getRoot(Word* data) const {
     initializeDegComp(data);
     return m_;
   }
 
-  int getChild(DirectedFrontierData* data, int level, int value) const {
+  int getChild(Word* data, int level, int value) const {
     assert(1 <= level && level <= m_);
 
     // edge index (starting from 0)
@@ -132,23 +267,30 @@ class FrontierDirectedSTPathSpec
     const Digraph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
 
     // initialize deg and comp of the vertices newly entering the frontier
-    const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+    const VertexList entering_vs = fm_.getEnteringVs(edge_index);
     for (size_t i = 0; i < entering_vs.size(); ++i) {
       int v = entering_vs[i];
       // initially the value of deg is 0
       setIndeg(data, v, 0);
       setOutdeg(data, v, 0);
-      // initially the value of comp is the vertex number itself
-      setComp(data, v, v);
+      // initially the value of comp is the position of the vertex itself
+      setComp(data, v, fm_.vertexToPos(v));
     }
 
     // vertices on the frontier
-    const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
+    const VertexList frontier_vs = cursor_.getFrontierVs(edge_index);
+
+    // whether comp of some vertices may be no longer normalized
+    bool comp_changed = false;
 
     if (value == 1) {  // if we take the edge (go to 1-arc)
       // increment deg of v1 and v2 (recall that edge = {v1, v2})
       auto outdeg1 = getOutdeg(data, edge.v1);
       auto indeg2 = getIndeg(data, edge.v2);
+      // The indeg and outdeg of every vertex must be at most 1.
+      if (outdeg1 > 0 || indeg2 > 0) {
+        return 0;
+      }
 
       setIndeg(data, edge.v2, indeg2 + 1);
       setOutdeg(data, edge.v1, outdeg1 + 1);
@@ -156,6 +298,7 @@ class FrontierDirectedSTPathSpec
       short c1 = getComp(data, edge.v1);
       short c2 = getComp(data, edge.v2);
       if (c1 != c2) {  // connected components c1 and c2 become connected
+        comp_changed = true;
         short cmin = std::min(c1, c2);
         short cmax = std::max(c1, c2);
 
@@ -170,7 +313,7 @@ class FrontierDirectedSTPathSpec
     }
 
     // vertices that are leaving the frontier
-    const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+    const VertexList leaving_vs = fm_.getLeavingVs(edge_index);
     for (size_t i = 0; i < leaving_vs.size(); ++i) {
       int v = leaving_vs[i];
 
@@ -279,14 +422,20 @@ class FrontierDirectedSTPathSpec
       }
       // Since deg and comp of v are never used until the end,
       // we erase the values.
-      setIndeg(data, v, -1);
-      setOutdeg(data, v, -1);
-      setComp(data, v, -1);
+      layout_.clear(data, fm_.vertexToPos(v));
     }
     if (level == 1) {
       // If we come here, the edge set is empty (taking no edge).
       return 0;
     }
+    if (comp_changed || !leaving_vs.empty()) {
+      normalizeComp(data, edge_index);
+    }
+    if (to_t_.isAvailable() && s_ != t_ &&
+        (!isLinkable(data, edge_index, true) ||
+         !isLinkable(data, edge_index, false))) {
+      return 0;
+    }
     assert(level - 1 > 0);
     return level - 1;
   }
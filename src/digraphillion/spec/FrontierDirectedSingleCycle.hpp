@@ -35,8 +35,10 @@ using namespace tdzdd;
 
 class FrontierDirectedSingleCycleSpec
     : public tdzdd::PodArrayDdSpec<FrontierDirectedSingleCycleSpec,
-                                   DirectedFrontierData, 2> {
+                                   PackedDirectedFrontierLayout::Word, 2> {
  private:
+  typedef PackedDirectedFrontierLayout::Word Word;
+
   // input graph
   const tdzdd::Digraph& graph_;
   // number of vertices
@@ -44,64 +46,81 @@ class FrontierDirectedSingleCycleSpec
   // number of edges
   const int m_;
 
-  const FrontierManager fm_;
+  // frontier manager shared by the specs built on graph_
+  const FrontierManager& fm_;
+  // frontier lists of the edge being processed, rebuilt from fm_
+  mutable FrontierCursor cursor_;
+  // packed layout of the states
+  const PackedDirectedFrontierLayout layout_;
 
   // This function gets deg of v.
-  short getIndeg(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].indeg;
+  short getIndeg(Word* data, short v) const {
+    return layout_.getIndeg(data, fm_.vertexToPos(v));
   }
 
-  short getOutdeg(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].outdeg;
+  short getOutdeg(Word* data, short v) const {
+    return layout_.getOutdeg(data, fm_.vertexToPos(v));
   }
 
   // This function sets deg of v to be d.
-  void setIndeg(DirectedFrontierData* data, short v, short d) const {
-    data[fm_.vertexToPos(v)].indeg = d;
+  void setIndeg(Word* data, short v, short d) const {
+    layout_.setIndeg(data, fm_.vertexToPos(v), d);
   }
 
-  void setOutdeg(DirectedFrontierData* data, short v, short d) const {
-    data[fm_.vertexToPos(v)].outdeg = d;
+  void setOutdeg(Word* data, short v, short d) const {
+    layout_.setOutdeg(data, fm_.vertexToPos(v), d);
   }
 
   // This function gets comp of v.
-  short getComp(DirectedFrontierData* data, short v) const {
-    return data[fm_.vertexToPos(v)].comp;
+  short getComp(Word* data, short v) const {
+    return layout_.getComp(data, fm_.vertexToPos(v));
   }
 
   // This function sets comp of v to be c.
-  void setComp(DirectedFrontierData* data, short v, short c) const {
-    data[fm_.vertexToPos(v)].comp = c;
+  void setComp(Word* data, short v, short c) const {
+    layout_.setComp(data, fm_.vertexToPos(v), c);
   }
 
-  void initializeDegComp(DirectedFrontierData* data) const {
-    for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
-      data[i].indeg = 0;
-      data[i].outdeg = 0;
-      data[i].comp = 0;
-    }
+  // This function renumbers comp of the vertices remaining on the frontier
+  // after the (edge_index)-th edge is processed (see
+  // FrontierManager::normalizeComp).
+  void normalizeComp(Word* data, int edge_index) const {
+    fm_.normalizeComp(
+        cursor_.getRemainingVs(edge_index),
+        [&](int v) { return getComp(data, v); },
+        [&](int v, int c) { setComp(data, v, static_cast<short>(c)); });
   }
 
+  void initializeDegComp(Word* data) const { layout_.clearAll(data); }
+
  public:
-  FrontierDirectedSingleCycleSpec(const tdzdd::Digraph& graph)
+  FrontierDirectedSingleCycleSpec(const tdzdd::Digraph& graph,
+                                  const FrontierManager& fm)
       : graph_(graph),
         n_(static_cast<short>(graph_.vertexSize())),
         m_(graph_.edgeSize()),
-        fm_(graph_) {
+        fm_(fm),
+        cursor_(fm),
+        layout_(fm_.getMaxFrontierSize(), fm_.getMaxComp()) {
     if (graph_.vertexSize() > SHRT_MAX) {  // SHRT_MAX == 32767
       std::cerr << "The number of vertices should be at most " << SHRT_MAX
                 << std::endl;
       exit(1);
     }
-    setArraySize(fm_.getMaxFrontierSize());
+    setArraySize(layout_.numWords());
+    std::vector<int> level_sizes = fm_.getStateWidthsByLevel();
+    for (size_t i = 0; i < level_sizes.size(); ++i) {
+      level_sizes[i] = layout_.numWords(level_sizes[i]);
+    }
+    setLevelArraySizes(level_sizes);
   }
 
-  int getRoot(DirectedFrontierData* data) const {
+  int getRoot(Word* data) const {
     initializeDegComp(data);
     return m_;
   }
 
-  int getChild(DirectedFrontierData* data, int level, int value) const {
+  int getChild(Word* data, int level, int value) const {
     assert(1 <= level && level <= m_);
 
     // edge index (starting from 0)
@@ -111,23 +130,30 @@ class FrontierDirectedSingleCycleSpec
     const Digraph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
 
     // initialize deg and comp of the vertices newly entering the frontier
-    const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+    const VertexList entering_vs = fm_.getEnteringVs(edge_index);
     for (size_t i = 0; i < entering_vs.size(); ++i) {
       int v = entering_vs[i];
       // initially the value of deg is 0
       setIndeg(data, v, 0);
       setOutdeg(data, v, 0);
-      // initially the value of comp is the vertex number itself
-      setComp(data, v, v);
+      // initially the value of comp is the position of the vertex itself
+      setComp(data, v, fm_.vertexToPos(v));
     }
 
     // vertices on the frontier
-    const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
+    const VertexList frontier_vs = cursor_.getFrontierVs(edge_index);
+
+    // whether comp of some vertices may be no longer normalized
+    bool comp_changed = false;
 
     if (value == 1) {  // if we take the edge (go to 1-arc)
       // increment deg of v1 and v2 (recall that edge = {v1, v2})
       auto outdeg1 = getOutdeg(data, edge.v1);
       auto indeg2 = getIndeg(data, edge.v2);
+      // The indeg and outdeg of every vertex must be at most 1.
+      if (outdeg1 > 0 || indeg2 > 0) {
+        return 0;
+      }
 
       setIndeg(data, edge.v2, indeg2 + 1);
       setOutdeg(data, edge.v1, outdeg1 + 1);
@@ -135,6 +161,7 @@ class FrontierDirectedSingleCycleSpec
       short c1 = getComp(data, edge.v1);
       short c2 = getComp(data, edge.v2);
       if (c1 != c2) {  // connected components c1 and c2 become connected
+        comp_changed = true;
         short cmin = std::min(c1, c2);
         short cmax = std::max(c1, c2);
 
@@ -149,7 +176,7 @@ class FrontierDirectedSingleCycleSpec
     }
 
     // vertices that are leaving the frontier
-    const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+    const VertexList leaving_vs = fm_.getLeavingVs(edge_index);
     for (size_t i = 0; i < leaving_vs.size(); ++i) {
       int v = leaving_vs[i];
 
@@ -222,14 +249,15 @@ class FrontierDirectedSingleCycleSpec
       }
       // Since deg and comp of v are never used until the end,
       // we erase the values.
-      setIndeg(data, v, -1);
-      setOutdeg(data, v, -1);
-      setComp(data, v, -1);
+      layout_.clear(data, fm_.vertexToPos(v));
     }
     if (level == 1) {
       // If we come here, the edge set is empty (taking no edge).
       return 0;
     }
+    if (comp_changed || !leaving_vs.empty()) {
+      normalizeComp(data, edge_index);
+    }
     assert(level - 1 > 0);
     return level - 1;
   }
@@ -23,89 +23,155 @@ SOFTWARE.
 #ifndef __FRONTIER_MANAGER_HPP
 #define __FRONTIER_MANAGER_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
 #include <vector>
 
 #include "subsetting/util/Digraph.hpp"
 
 using namespace tdzdd;
 
+// Read-only view of a list of vertex numbers stored in FrontierManager.
+class VertexList {
+ private:
+  const int* begin_;
+  const int* end_;
+
+ public:
+  VertexList(const int* begin, const int* end) : begin_(begin), end_(end) {}
+
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+  int operator[](size_t i) const { return begin_[i]; }
+  int at(size_t i) const {
+    if (i >= size()) throw std::out_of_range("VertexList::at");
+    return begin_[i];
+  }
+  const int* begin() const { return begin_; }
+  const int* end() const { return end_; }
+};
+
 // This class manages vertex numbers on the frontier
 // and where deg/comp of each vertex is stored.
+// The frontier of the i-th edge consists of the vertices each of
+// which is incident to both at least one of e_0, e_1,...,e_{i-1}
+// and at least one of e_{i+1},e_{i+2},...,e_{m-1}, and also of
+// both endpoints of e_i, where m is the number of edges.
+// Note that the definition of the frontier is different from
+// that in the paper [Kawahara+ 2017].
+// Only the vertices entering and leaving the frontier are stored for each
+// edge, in flat arrays where the list of the i-th edge is
+// vss[offsets[i]], ..., vss[offsets[i + 1] - 1]; FrontierCursor rebuilds
+// the frontier itself from them.
+// One FrontierManager can be shared by all the specs built on the graph.
 class FrontierManager {
  private:
   // input graph
   const tdzdd::Digraph& graph_;
 
-  // frontier_vss_[i] stores the vertices each of
-  // which is incident to both at least one of e_0, e_1,...,e_{i-1}
-  // and at least one of e_{i+1},e_{i+2},...,e_{m-1}, and also stores
-  // both endpoints of e_i, where m is the number of edges.
-  // Note that the definition of the frontier is different from
-  // that in the paper [Kawahara+ 2017].
-  // "vss" stands for "vertex set set".
-  std::vector<std::vector<int> > frontier_vss_;
-
-  // entering_vss_[i] stores the vertex numbers
+  // entering_vss_ stores, for the i-th edge, the vertex numbers
   // that newly enter the frontier when processing the i-th edge.
-  std::vector<std::vector<int> > entering_vss_;
+  std::vector<int> entering_vss_;
+  std::vector<int> entering_offsets_;
 
-  // leaving_vss_[i] stores the vertex numbers
+  // leaving_vss_ stores, for the i-th edge, the vertex numbers
   // that leave the frontier after the i-th edge is processed.
-  std::vector<std::vector<int> > leaving_vss_;
+  std::vector<int> leaving_vss_;
+  std::vector<int> leaving_offsets_;
 
-  std::vector<std::vector<int> > remaining_vss_;
+  // frontier_sizes_[i] stores the number of the vertices on the frontier
+  // of the i-th edge.
+  std::vector<int> frontier_sizes_;
 
   // translate the vertex number to the position in the PodArray
   std::vector<int> vertex_to_pos_;
-  std::vector<std::vector<int> > pos_to_vertex_;
+
+  // the index of the edge when processing which each vertex enters
+  // and leaves the frontier
+  std::vector<int> entering_index_;
+  std::vector<int> leaving_index_;
+
+  // in_edges_ stores, for each vertex v, the indices of the edges into v
+  // in ascending order, which are in_edges_[in_offsets_[v]], ...,
+  // in_edges_[in_offsets_[v + 1] - 1]; out_edges_ is the same for the
+  // edges out of v.
+  std::vector<int> in_edges_;
+  std::vector<int> in_offsets_;
+  std::vector<int> out_edges_;
+  std::vector<int> out_offsets_;
+
+  // the index of the last edge at which some vertex enters the frontier
+  int all_entering_index_;
 
   // the maximum frontier size
   int max_frontier_size_;
 
-  void constructEnteringAndLeavingVss() {
+  // state_widths_[i] stores one plus the maximum position of the vertices
+  // remaining on the frontier before the i-th edge is processed
+  // (0 if there is no such vertex).
+  std::vector<int> state_widths_;
+
+  void construct() {
     const int n = graph_.vertexSize();
     const int m = graph_.edgeSize();
+    max_frontier_size_ = 0;
+    all_entering_index_ = -1;
 
-    entering_vss_.resize(m);
-    leaving_vss_.resize(m);
+    entering_index_.assign(n + 1, -1);
+    leaving_index_.assign(n + 1, -1);
+    for (int i = 0; i < m; ++i) {
+      const tdzdd::Digraph::EdgeInfo& e = graph_.edgeInfo(i);
+      if (entering_index_[e.v1] < 0) entering_index_[e.v1] = i;
+      if (entering_index_[e.v2] < 0) entering_index_[e.v2] = i;
+      leaving_index_[e.v1] = i;
+      leaving_index_[e.v2] = i;
+    }
 
-    // compute entering_vss_
-    std::set<int> entered_vs;
+    in_offsets_.assign(n + 2, 0);
+    out_offsets_.assign(n + 2, 0);
     for (int i = 0; i < m; ++i) {
       const tdzdd::Digraph::EdgeInfo& e = graph_.edgeInfo(i);
-      if (entered_vs.count(e.v1) == 0) {
-        entering_vss_[i].push_back(e.v1);
-        entered_vs.insert(e.v1);
-      }
-      if (entered_vs.count(e.v2) == 0) {
-        entering_vss_[i].push_back(e.v2);
-        entered_vs.insert(e.v2);
+      ++out_offsets_[e.v1 + 1];
+      ++in_offsets_[e.v2 + 1];
+    }
+    for (int v = 0; v <= n; ++v) {
+      in_offsets_[v + 1] += in_offsets_[v];
+      out_offsets_[v + 1] += out_offsets_[v];
+    }
+    in_edges_.resize(m);
+    out_edges_.resize(m);
+    {
+      std::vector<int> in_next(in_offsets_.begin(), in_offsets_.end() - 1);
+      std::vector<int> out_next(out_offsets_.begin(), out_offsets_.end() - 1);
+      for (int i = 0; i < m; ++i) {
+        const tdzdd::Digraph::EdgeInfo& e = graph_.edgeInfo(i);
+        out_edges_[out_next[e.v1]++] = i;
+        in_edges_[in_next[e.v2]++] = i;
       }
     }
-    assert(static_cast<int>(entered_vs.size()) == n);
 
-    // compute leaving_vss_
-    std::set<int> leaved_vs;
-    for (int i = m - 1; i >= 0; --i) {
+    entering_offsets_.push_back(0);
+    leaving_offsets_.push_back(0);
+    for (int i = 0; i < m; ++i) {
       const tdzdd::Digraph::EdgeInfo& e = graph_.edgeInfo(i);
-      if (leaved_vs.count(e.v1) == 0) {
-        leaving_vss_[i].push_back(e.v1);
-        leaved_vs.insert(e.v1);
+      if (entering_index_[e.v1] == i) entering_vss_.push_back(e.v1);
+      if (e.v2 != e.v1 && entering_index_[e.v2] == i) {
+        entering_vss_.push_back(e.v2);
+      }
+      if (leaving_index_[e.v1] == i) leaving_vss_.push_back(e.v1);
+      if (e.v2 != e.v1 && leaving_index_[e.v2] == i) {
+        leaving_vss_.push_back(e.v2);
       }
-      if (leaved_vs.count(e.v2) == 0) {
-        leaving_vss_[i].push_back(e.v2);
-        leaved_vs.insert(e.v2);
+      entering_offsets_.push_back(entering_vss_.size());
+      leaving_offsets_.push_back(leaving_vss_.size());
+      if (entering_offsets_[i + 1] > entering_offsets_[i]) {
+        all_entering_index_ = i;
       }
     }
-    assert(static_cast<int>(leaved_vs.size()) == n);
-  }
-
-  void construct() {
-    const int n = graph_.vertexSize();
-    const int m = graph_.edgeSize();
-    max_frontier_size_ = 0;
-
-    constructEnteringAndLeavingVss();
+    assert(static_cast<int>(entering_vss_.size()) == n);
+    assert(static_cast<int>(leaving_vss_.size()) == n);
 
     std::vector<int> unused;
     for (int i = n - 1; i >= 0; --i) {
@@ -113,153 +179,301 @@ class FrontierManager {
     }
 
     vertex_to_pos_.resize(n + 1);
-    pos_to_vertex_.resize(m);
-    for (int i = 0; i < m; ++i) {
-      pos_to_vertex_[i].resize(n + 1);
-    }
+    frontier_sizes_.resize(m);
 
-    std::set<int> current_vs;
+    // the number of the vertices on the frontier
+    int frontier_size = 0;
     for (int i = 0; i < m; ++i) {
-      if (i > 0) {
-        for (int j = 0; j < n + 1; ++j) {
-          pos_to_vertex_[i][j] = pos_to_vertex_[i - 1][j];
-        }
-      }
-      const std::vector<int>& entering_vs = entering_vss_[i];
+      const VertexList entering_vs = getEnteringVs(i);
       for (size_t j = 0; j < entering_vs.size(); ++j) {
-        int v = entering_vs[j];
-        current_vs.insert(v);
         int u = unused.back();
         unused.pop_back();
-        vertex_to_pos_[v] = u;
-        pos_to_vertex_[i][u] = v;
+        vertex_to_pos_[entering_vs[j]] = u;
       }
+      frontier_size += entering_vs.size();
+      max_frontier_size_ = std::max(max_frontier_size_, frontier_size);
+      frontier_sizes_[i] = frontier_size;
 
-      if (static_cast<int>(current_vs.size()) > max_frontier_size_) {
-        max_frontier_size_ = current_vs.size();
+      const VertexList leaving_vs = getLeavingVs(i);
+      for (size_t j = 0; j < leaving_vs.size(); ++j) {
+        unused.push_back(vertex_to_pos_[leaving_vs[j]]);
       }
+      frontier_size -= leaving_vs.size();
+    }
 
-      const std::vector<int>& leaving_vs = leaving_vss_[i];
-
-      frontier_vss_.push_back(std::vector<int>());
-      std::vector<int>& vs = frontier_vss_.back();
-      remaining_vss_.push_back(std::vector<int>());
-      std::vector<int>& rs = remaining_vss_.back();
-      for (std::set<int>::const_iterator itor = current_vs.begin();
-           itor != current_vs.end(); ++itor) {
-        vs.push_back(*itor);
-
-        bool found_leaving = false;
-        for (size_t j = 0; j < leaving_vs.size(); ++j) {
-          int v = leaving_vs[j];
-          if (v == *itor) {
-            found_leaving = true;
-            break;
-          }
-        }
-        if (!found_leaving) {
-          rs.push_back(*itor);
-        }
+    constructStateWidths();
+  }
+
+  // This function computes state_widths_, where state_widths_[i + 1] is
+  // one plus the maximum position of the vertices v remaining on the
+  // frontier after the i-th edge, i.e., entering_index_[v] <= i and
+  // i < leaving_index_[v].  The vertices are visited in descending order
+  // of the positions, and each width is set by the first vertex remaining
+  // there; the widths already set are skipped by union-find, so that this
+  // takes almost linear time.
+  void constructStateWidths() {
+    const int n = graph_.vertexSize();
+    const int m = graph_.edgeSize();
+
+    // the vertices sorted by the positions
+    std::vector<int> offsets(max_frontier_size_ + 1, 0);
+    for (int v = 1; v <= n; ++v) {
+      ++offsets[vertex_to_pos_[v] + 1];
+    }
+    for (int p = 0; p < max_frontier_size_; ++p) {
+      offsets[p + 1] += offsets[p];
+    }
+    std::vector<int> vs(n);
+    {
+      std::vector<int> next(offsets.begin(), offsets.end() - 1);
+      for (int v = 1; v <= n; ++v) {
+        vs[next[vertex_to_pos_[v]]++] = v;
       }
+    }
 
-      for (size_t j = 0; j < leaving_vs.size(); ++j) {
-        int v = leaving_vs[j];
-        current_vs.erase(v);
-        unused.push_back(vertex_to_pos_[v]);
+    // unset[k] leads to the smallest index k' >= k whose width is not set
+    std::vector<int> unset(m + 2);
+    for (int k = 0; k <= m + 1; ++k) {
+      unset[k] = k;
+    }
+    state_widths_.assign(m + 1, 0);
+    for (int j = n - 1; j >= 0; --j) {
+      const int v = vs[j];
+      const int end = leaving_index_[v];
+      for (int k = findUnset(&unset, entering_index_[v] + 1); k <= end;
+           k = findUnset(&unset, k + 1)) {
+        state_widths_[k] = vertex_to_pos_[v] + 1;
+        unset[k] = k + 1;
       }
     }
   }
 
+  static int findUnset(std::vector<int>* unset, int k) {
+    std::vector<int>& u = *unset;
+    while (u[k] != k) {
+      u[k] = u[u[k]];  // path halving
+      k = u[k];
+    }
+    return k;
+  }
+
+  static int countAfter(const std::vector<int>& edges,
+                        const std::vector<int>& offsets, int index, int v) {
+    const std::vector<int>::const_iterator end = edges.begin() + offsets[v + 1];
+    return end - std::upper_bound(edges.begin() + offsets[v], end, index);
+  }
+
+  static VertexList listAt(const std::vector<int>& vss,
+                           const std::vector<int>& offsets, int index) {
+    const int* p = vss.empty() ? NULL : &vss[0];
+    return VertexList(p + offsets[index], p + offsets[index + 1]);
+  }
+
  public:
   FrontierManager(const tdzdd::Digraph& graph) : graph_(graph) { construct(); }
 
   // This function returns the maximum frontier size.
   int getMaxFrontierSize() const { return max_frontier_size_; }
 
-  // This function returns the vector that stores the vertex numbers
-  // that newly enter the frontier when processing the (index)-th edge.
-  const std::vector<int>& getEnteringVs(int index) const {
-    return entering_vss_[index];
+  // This function returns the maximum comp stored by the specs
+  // that call normalizeComp, which is (2 * frontier size - 1).
+  int getMaxComp() const { return 2 * max_frontier_size_ - 1; }
+
+  // This function renumbers comp of the vertices in remaining_vs, which
+  // remain on the frontier after some edge is processed, so that comp of
+  // each connected component is the position of its first vertex.
+  // Thus, the states representing the same partition of the frontier
+  // become identical and are merged into one node.
+  // getComp(v) and setComp(v, c) get and set comp of v in the state,
+  // which must hold comp up to getMaxComp() while renumbering.
+  template <typename GetComp, typename SetComp>
+  void normalizeComp(const VertexList& remaining_vs, GetComp getComp,
+                     SetComp setComp) const {
+    // New numbers are shifted by offset while renumbering
+    // so as not to be confused with the old ones, which are
+    // positions (smaller than offset).
+    const int offset = max_frontier_size_;
+    for (size_t i = 0; i < remaining_vs.size(); ++i) {
+      int c = getComp(remaining_vs[i]);
+      if (c >= offset) {  // already renumbered
+        continue;
+      }
+      int nc = vertex_to_pos_[remaining_vs[i]] + offset;
+      for (size_t j = i; j < remaining_vs.size(); ++j) {
+        if (getComp(remaining_vs[j]) == c) {
+          setComp(remaining_vs[j], nc);
+        }
+      }
+    }
+    for (size_t i = 0; i < remaining_vs.size(); ++i) {
+      int v = remaining_vs[i];
+      setComp(v, getComp(v) - offset);
+    }
   }
 
-  // This function returns the vector that stores the vertex numbers
-  // that leave the frontier after the (index)-th edge is processed.
-  const std::vector<int>& getLeavingVs(int index) const {
-    return leaving_vss_[index];
+  // This function returns the number of positions in the PodArray
+  // used by the states before the (index)-th edge is processed.
+  int getStateWidth(int index) const { return state_widths_[index]; }
+
+  // This function returns the state widths indexed by the level,
+  // where the (index)-th edge is processed at level m - index.
+  std::vector<int> getStateWidthsByLevel() const {
+    const int m = graph_.edgeSize();
+    std::vector<int> widths(m + 1);
+    for (int level = 0; level <= m; ++level) {
+      widths[level] = state_widths_[m - level];
+    }
+    return widths;
   }
 
-  // This function returns the vector that stores the vertex numbers
-  // that leave the frontier after the (index)-th edge is processed.
-  const std::vector<int>& getFrontierVs(int index) const {
-    return frontier_vss_[index];
+  // This function returns the list of the vertex numbers
+  // that newly enter the frontier when processing the (index)-th edge.
+  VertexList getEnteringVs(int index) const {
+    return listAt(entering_vss_, entering_offsets_, index);
   }
 
-  // This function returns the vector that stores ...
-  // <add comments ********>
-  const std::vector<int>& getRemainingVs(int index) const {
-    return remaining_vss_[index];
+  // This function returns the list of the vertex numbers
+  // that leave the frontier after the (index)-th edge is processed.
+  VertexList getLeavingVs(int index) const {
+    return listAt(leaving_vss_, leaving_offsets_, index);
   }
 
+  // This function returns the number of the vertices
+  // that are on the frontier when processing the (index)-th edge.
+  int getFrontierSize(int index) const { return frontier_sizes_[index]; }
+
   // This function translates the vertex number to the position
   // in the PodArray used by FrontierExampleSpec.
   int vertexToPos(int v) const { return vertex_to_pos_[v]; }
 
-  int posToVertex(int index, int pos) const {
-    return pos_to_vertex_[index][pos];
+  // This function returns the index of the edge when processing which
+  // v enters the frontier.
+  int getVerticesEnteringLevel(short v) const { return entering_index_[v]; }
+
+  // This function returns the index of the last edge when processing
+  // which some vertex enters the frontier.
+  int getAllVerticesEnteringLevel() const { return all_entering_index_; }
+
+  // This function returns the number of the edges into v that remain
+  // unprocessed after the (index)-th edge is processed.
+  int getRemainingIndeg(int index, int v) const {
+    return countAfter(in_edges_, in_offsets_, index, v);
   }
 
-  int getVerticesEnteringLevel(short v) const {
-    for (size_t i = 0; i < entering_vss_.size(); ++i) {
-      for (size_t j = 0; j < entering_vss_[i].size(); ++j) {
-        if (entering_vss_[i][j] == v) {
-          return static_cast<int>(i);
-        }
-      }
+  // This function returns the number of the edges out of v that remain
+  // unprocessed after the (index)-th edge is processed.
+  int getRemainingOutdeg(int index, int v) const {
+    return countAfter(out_edges_, out_offsets_, index, v);
+  }
+
+  void print() const;
+};
+
+// This class rebuilds the lists of the vertices on the frontier of
+// a FrontierManager from the entering and leaving vertices, moving one
+// edge at a time, which takes time linear in the frontier size.
+// The builders process the edges in order and copy the spec for each
+// thread, so each spec keeps its own cursor, which seldom moves more
+// than one edge.
+class FrontierCursor {
+ private:
+  const FrontierManager* fm_;
+
+  // the index of the edge of the lists, or -1 before the first edge
+  int index_;
+
+  // the vertex numbers that are on the frontier when processing the
+  // (index_)-th edge, and those remaining after it, in ascending order
+  std::vector<int> frontier_vs_;
+  std::vector<int> remaining_vs_;
+
+  static bool contains(const VertexList& vs, int v) {
+    return std::find(vs.begin(), vs.end(), v) != vs.end();
+  }
+
+  // This function sets *to to be the union of from and the vertices in vs,
+  // which are not in from.
+  static void unite(const std::vector<int>& from, const VertexList& vs,
+                    std::vector<int>* to) {
+    to->assign(from.begin(), from.end());
+    for (size_t i = 0; i < vs.size(); ++i) {
+      to->insert(std::lower_bound(to->begin(), to->end(), vs[i]), vs[i]);
     }
-    return -1;
   }
 
-  int getAllVerticesEnteringLevel() const {
-    int n = static_cast<int>(entering_vss_.size());
+  // This function sets *to to be from without the vertices in vs.
+  static void subtract(const std::vector<int>& from, const VertexList& vs,
+                       std::vector<int>* to) {
+    to->clear();
+    for (size_t i = 0; i < from.size(); ++i) {
+      if (!contains(vs, from[i])) to->push_back(from[i]);
+    }
+  }
 
-    for (int i = n - 1; i >= 0; --i) {
-      if (entering_vss_[i].size() > 0) {
-        return i;
+  static VertexList listOf(const std::vector<int>& vs) {
+    const int* p = vs.empty() ? NULL : &vs[0];
+    return VertexList(p, p + vs.size());
+  }
+
+  void moveTo(int index) {
+    for (; index_ < index; ++index_) {
+      unite(remaining_vs_, fm_->getEnteringVs(index_ + 1), &frontier_vs_);
+      subtract(frontier_vs_, fm_->getLeavingVs(index_ + 1), &remaining_vs_);
+    }
+    for (; index_ > index; --index_) {
+      subtract(frontier_vs_, fm_->getEnteringVs(index_), &remaining_vs_);
+      if (index_ > 0) {
+        unite(remaining_vs_, fm_->getLeavingVs(index_ - 1), &frontier_vs_);
+      } else {
+        frontier_vs_.clear();
       }
     }
-    return -1;
   }
 
-  void print() {
-    for (int i = 0; i < graph_.edgeSize(); ++i) {
-      std::cout << "[";
-      for (size_t j = 0; j < entering_vss_[i].size(); ++j) {
-        std::cout << entering_vss_[i][j] << ", ";
-      }
-      std::cout << "]";
-      std::cout << "[";
-      for (size_t j = 0; j < leaving_vss_[i].size(); ++j) {
-        std::cout << leaving_vss_[i][j] << ", ";
-      }
-      std::cout << "]";
+ public:
+  explicit FrontierCursor(const FrontierManager& fm) : fm_(&fm), index_(-1) {
+    frontier_vs_.reserve(fm.getMaxFrontierSize());
+    remaining_vs_.reserve(fm.getMaxFrontierSize());
+  }
+
+  // This function returns the list of the vertex numbers
+  // that are on the frontier when processing the (index)-th edge.
+  // The list is valid until the cursor is given another index.
+  VertexList getFrontierVs(int index) {
+    moveTo(index);
+    return listOf(frontier_vs_);
+  }
+
+  // This function returns the list of the vertex numbers that remain
+  // on the frontier after the (index)-th edge is processed.
+  // The list is valid until the cursor is given another index.
+  VertexList getRemainingVs(int index) {
+    moveTo(index);
+    return listOf(remaining_vs_);
+  }
+};
+
+inline void FrontierManager::print() const {
+  FrontierCursor cursor(*this);
+  for (int i = 0; i < graph_.edgeSize(); ++i) {
+    const VertexList frontier_vs = cursor.getFrontierVs(i);
+    const VertexList lists[] = {getEnteringVs(i), getLeavingVs(i),
+                                frontier_vs, cursor.getRemainingVs(i)};
+    for (size_t k = 0; k < 4; ++k) {
       std::cout << "[";
-      for (size_t j = 0; j < frontier_vss_[i].size(); ++j) {
-        std::cout << frontier_vss_[i][j] << ", ";
+      for (size_t j = 0; j < lists[k].size(); ++j) {
+        std::cout << lists[k][j] << ", ";
       }
       std::cout << "]";
-      std::cout << "[";
-      for (size_t j = 0; j < remaining_vss_[i].size(); ++j) {
-        std::cout << remaining_vss_[i][j] << ", ";
-      }
-      std::cout << "]" << std::endl;
-    }
-
-    for (int v = 1; v <= graph_.vertexSize(); ++v) {
-      std::cout << vertex_to_pos_[v] << ", ";
     }
+    std::cout << std::endl;
+  }
 
-    std::cout << "max f size = " << max_frontier_size_ << std::endl;
+  for (int v = 1; v <= graph_.vertexSize(); ++v) {
+    std::cout << vertex_to_pos_[v] << ", ";
   }
-};
+
+  std::cout << "max f size = " << max_frontier_size_ << std::endl;
+}
 
 #endif  // __FRONTIER_MANAGER_HPP
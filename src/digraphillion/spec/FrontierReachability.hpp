@@ -0,0 +1,207 @@
+/**
+Copyright (c) 2021 ComputerAlgorithmsGroupAtKyotoU
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef FRONTIER_REACHABILITY_HPP
+#define FRONTIER_REACHABILITY_HPP
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "FrontierManager.hpp"
+#include "subsetting/util/Digraph.hpp"
+
+// This class stores, for each edge index i, the reachability among the
+// vertices remaining on the frontier after the i-th edge is processed,
+// using only the unprocessed edges e_{i+1}, ..., e_{m-1}.  If forward is
+// false, the edges are reversed.  The sets of vertices are bit masks of
+// the positions given by FrontierManager, so the reachability is
+// available only if the maximum frontier size is at most 64.
+//
+// The reachability is computed from the last edge backwards by adding
+// one edge at a time.  Only the closure among the frontier vertices is
+// kept, because the vertices that have not entered the frontier yet get
+// no more edges, and the paths through them are already in the closure.
+// Each edge takes O(w) time, where w is the maximum frontier size.
+class FrontierReachability {
+ public:
+  typedef uint64_t Mask;
+  enum Triviality { NEVER, ALWAYS, IF_TARGET_OPEN };
+
+ private:
+  int width_;
+  bool available_;
+
+  // reach_[i * width_ + p] is the set of the frontier vertices reachable
+  // by one or more edges from the vertex at position p
+  std::vector<Mask> reach_;
+  // target_[i] is the set of the frontier vertices from which the target
+  // is reachable by one or more edges
+  std::vector<Mask> target_;
+  // trivial_[i] is ALWAYS if the target has not entered the frontier yet
+  // and is reachable from all the frontier vertices, or if it has left
+  // and all the frontier vertices are reachable from each other, in which
+  // case any state can be linked to the target; it is IF_TARGET_OPEN if
+  // the target is on the frontier and reachable from all the other
+  // frontier vertices, in which case the same holds unless the target is
+  // already linked
+  std::vector<char> trivial_;
+  // the vertices on the frontier without unprocessed edges out of them
+  // after the i-th edge is processed are stuck_vss_[stuck_ranges_[i].first],
+  // ..., stuck_vss_[stuck_ranges_[i].second - 1]
+  std::vector<int> stuck_vss_;
+  std::vector<std::pair<int, int> > stuck_ranges_;
+
+  static Mask bit(int pos) { return static_cast<Mask>(1) << pos; }
+
+ public:
+  FrontierReachability(const tdzdd::Digraph& graph, const FrontierManager& fm,
+                       int target, bool forward)
+      : width_(fm.getMaxFrontierSize()),
+        available_(fm.getMaxFrontierSize() <= 64) {
+    if (!available_) return;
+    const int n = graph.vertexSize();
+    const int m = graph.edgeSize();
+    reach_.assign(static_cast<size_t>(m) * width_, 0);
+    target_.assign(m, 0);
+    trivial_.assign(m, 0);
+    stuck_ranges_.resize(m);
+
+    // closure[p] and to_target are reach_ and target_ for the current
+    // edge index, where the positions not on the frontier are kept 0
+    std::vector<Mask> closure(width_, 0);
+    Mask to_target = 0;
+    // the number of the unprocessed edges out of each vertex
+    std::vector<int> outdeg(n + 1, 0);
+    FrontierCursor cursor(fm);
+    for (int i = m - 1; i >= 0; --i) {
+      const VertexList vs = cursor.getRemainingVs(i);
+      for (size_t j = 0; j < vs.size(); ++j) {
+        const int p = fm.vertexToPos(vs[j]);
+        reach_[static_cast<size_t>(i) * width_ + p] = closure[p];
+      }
+      target_[i] = to_target;
+      stuck_ranges_[i].first = stuck_vss_.size();
+      for (size_t j = 0; j < vs.size(); ++j) {
+        if (outdeg[vs[j]] == 0) stuck_vss_.push_back(vs[j]);
+      }
+      stuck_ranges_[i].second = stuck_vss_.size();
+
+      // The stuck vertices are ignored, since they are checked separately.
+      if (fm.getVerticesEnteringLevel(target) > i) {
+        trivial_[i] = ALWAYS;
+        for (size_t j = 0; j < vs.size(); ++j) {
+          const Mask b = bit(fm.vertexToPos(vs[j]));
+          if (outdeg[vs[j]] > 0 && !(target_[i] & b)) trivial_[i] = NEVER;
+        }
+      } else if (std::find(vs.begin(), vs.end(), target) != vs.end()) {
+        const Mask t = bit(fm.vertexToPos(target));
+        trivial_[i] = IF_TARGET_OPEN;
+        for (size_t j = 0; j < vs.size(); ++j) {
+          const int v = vs[j];
+          if (v != target && outdeg[v] > 0 &&
+              !(reachable(i, fm.vertexToPos(v)) & t)) {
+            trivial_[i] = NEVER;
+          }
+        }
+      } else {
+        // The target has left the frontier, and the fragment ending at it
+        // can be reached from anywhere if the frontier vertices that have
+        // unprocessed edges into them are reachable from each other.
+        Mask enterable = 0;
+        for (size_t j = 0; j < vs.size(); ++j) {
+          enterable |= reachable(i, fm.vertexToPos(vs[j]));
+        }
+        trivial_[i] = ALWAYS;
+        for (size_t j = 0; j < vs.size(); ++j) {
+          const int p = fm.vertexToPos(vs[j]);
+          if (outdeg[vs[j]] > 0 &&
+              (enterable & ~(reachable(i, p) | bit(p))) != 0) {
+            trivial_[i] = NEVER;
+          }
+        }
+      }
+
+      // Add the i-th edge u -> v.  The vertices leaving the frontier at
+      // the i-th edge join it with no edges, and their positions are
+      // still 0 in closure.
+      const tdzdd::Digraph::EdgeInfo& e = graph.edgeInfo(i);
+      const int u = forward ? e.v1 : e.v2;
+      const int v = forward ? e.v2 : e.v1;
+      const Mask bu = bit(fm.vertexToPos(u));
+      const Mask bv = bit(fm.vertexToPos(v));
+      const Mask to_v = closure[fm.vertexToPos(v)] | bv;
+      const bool v_to_target = v == target || (to_target & bv);
+      for (int p = 0; p < width_; ++p) {
+        if (bit(p) == bu || (closure[p] & bu)) {
+          closure[p] |= to_v;
+          if (v_to_target) to_target |= bit(p);
+        }
+      }
+      ++outdeg[u];
+
+      // The vertices entering the frontier at the i-th edge have not
+      // entered it yet before the i-th edge is processed.
+      const VertexList entering_vs = fm.getEnteringVs(i);
+      for (size_t j = 0; j < entering_vs.size(); ++j) {
+        const int p = fm.vertexToPos(entering_vs[j]);
+        closure[p] = 0;
+        for (int q = 0; q < width_; ++q) {
+          closure[q] &= ~bit(p);
+        }
+        to_target &= ~bit(p);
+      }
+    }
+  }
+
+  // This function returns false if the frontier is too large.
+  bool isAvailable() const { return available_; }
+
+  // This function returns the set of the vertices on the frontier
+  // reachable from the vertex at position pos after the (index)-th edge
+  // is processed.
+  Mask reachable(int index, int pos) const {
+    return reach_[static_cast<size_t>(index) * width_ + pos];
+  }
+
+  // This function returns the set of the vertices on the frontier from
+  // which the target is reachable after the (index)-th edge is processed.
+  Mask reachingTarget(int index) const { return target_[index]; }
+
+  // This function returns the list of the vertices on the frontier
+  // without unprocessed edges out of them after the (index)-th edge is
+  // processed, which cannot be extended any more.
+  VertexList getStuckVs(int index) const {
+    const int* p = stuck_vss_.empty() ? NULL : &stuck_vss_[0];
+    return VertexList(p + stuck_ranges_[index].first,
+                      p + stuck_ranges_[index].second);
+  }
+
+  // This function returns whether the target is reachable from all the
+  // vertices on the frontier after the (index)-th edge is processed.
+  Triviality getTriviality(int index) const {
+    return static_cast<Triviality>(trivial_[index]);
+  }
+};
+
+#endif  // FRONTIER_REACHABILITY_HPP
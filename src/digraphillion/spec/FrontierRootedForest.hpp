@@ -51,7 +51,10 @@ class FrontierRootedForestSpec
   // number of edges
   const int m_;
 
-  const FrontierManager fm_;
+  // frontier manager shared by the specs built on graph_
+  const FrontierManager& fm_;
+  // frontier lists of the edge being processed, rebuilt from fm_
+  mutable FrontierCursor cursor_;
 
   // This function gets deg of v.
   short getIndeg(DirectedFrontierData* data, short v) const {
@@ -81,6 +84,16 @@ class FrontierRootedForestSpec
     data[fm_.vertexToPos(v)].comp = c;
   }
 
+  // This function renumbers comp of the vertices remaining on the frontier
+  // after the (edge_index)-th edge is processed (see
+  // FrontierManager::normalizeComp).
+  void normalizeComp(DirectedFrontierData* data, int edge_index) const {
+    fm_.normalizeComp(
+        cursor_.getRemainingVs(edge_index),
+        [&](int v) { return getComp(data, v); },
+        [&](int v, int c) { setComp(data, v, static_cast<ushort>(c)); });
+  }
+
   void initializeData(DirectedFrontierData* data) const {
     for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
       data[i].indeg = 0;
@@ -89,8 +102,29 @@ class FrontierRootedForestSpec
     }
   }
 
+  // This function returns false if the edges remaining after the
+  // (edge_index)-th edge can no longer supply the degree v needs.  A root
+  // needs an outgoing edge, and a non-root vertex needs an incoming edge if
+  // it has an outgoing one or the forest is spanning.  If the roots are not
+  // specified, a vertex in a spanning forest needs some edge.
+  bool isDegreeFeasible(DirectedFrontierData* data, short v,
+                        int edge_index) const {
+    const bool can_in =
+        getIndeg(data, v) > 0 || fm_.getRemainingIndeg(edge_index, v) > 0;
+    const bool can_out =
+        getOutdeg(data, v) > 0 || fm_.getRemainingOutdeg(edge_index, v) > 0;
+    if (roots.empty()) {
+      return !is_spanning || can_in || can_out;
+    }
+    if (roots.count(v)) {
+      return can_out;
+    }
+    return can_in || (!is_spanning && getOutdeg(data, v) == 0);
+  }
+
  public:
   FrontierRootedForestSpec(const tdzdd::Digraph& graph,
+                           const FrontierManager& fm,
                            const std::set<tdzdd::Digraph::VertexNumber>& _roots,
                            bool _is_spanning)
       : graph_(graph),
@@ -98,13 +132,15 @@ class FrontierRootedForestSpec
         is_spanning(_is_spanning),
         n_(static_cast<short>(graph_.vertexSize())),
         m_(graph_.edgeSize()),
-        fm_(graph_) {
+        fm_(fm),
+        cursor_(fm) {
     if (n_ >= (1 << 16)) {
       std::cerr << "The number of vertices must be smaller than 2^15."
                 << std::endl;
       exit(1);
     }
     setArraySize(fm_.getMaxFrontierSize());
+    setLevelArraySizes(fm_.getStateWidthsByLevel());
   }
 
   int getRoot(DirectedFrontierData* data) const {
@@ -122,18 +158,21 @@ class FrontierRootedForestSpec
     const Digraph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
 
     // initialize deg and comp of the vertices newly entering the frontier
-    const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+    const VertexList entering_vs = fm_.getEnteringVs(edge_index);
     for (size_t i = 0; i < entering_vs.size(); ++i) {
       int v = entering_vs[i];
       // initially the value of deg is 0
       setIndeg(data, v, 0);
       setOutdeg(data, v, 0);
-      // initially the value of comp is the vertex number itself
-      setComp(data, v, static_cast<ushort>(v));
+      // initially the value of comp is the position of the vertex itself
+      setComp(data, v, static_cast<ushort>(fm_.vertexToPos(v)));
     }
 
     // vertices on the frontier
-    const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
+    const VertexList frontier_vs = cursor_.getFrontierVs(edge_index);
+
+    // whether comp of some vertices may be no longer normalized
+    bool comp_changed = false;
 
     if (value == 1) {  // if we take the edge (go to 1-arc)
       // increment deg of v1 and v2 (recall that edge = {v1, v2})
@@ -151,6 +190,7 @@ class FrontierRootedForestSpec
       }
 
       if (c1 != c2) {  // connected components c1 and c2 become connected
+        comp_changed = true;
         ushort cmin = std::min(c1, c2);
         ushort cmax = std::max(c1, c2);
 
@@ -164,8 +204,15 @@ class FrontierRootedForestSpec
       }
     }
 
+    // The degrees of the endpoints are checked against the edges that
+    // remain, since the other vertices are not changed by this edge.
+    if (!isDegreeFeasible(data, edge.v1, edge_index) ||
+        !isDegreeFeasible(data, edge.v2, edge_index)) {
+      return 0;
+    }
+
     // vertices that are leaving the frontier
-    const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+    const VertexList leaving_vs = fm_.getLeavingVs(edge_index);
     for (size_t i = 0; i < leaving_vs.size(); ++i) {
       int v = leaving_vs[i];
 
@@ -214,6 +261,9 @@ class FrontierRootedForestSpec
     if (level == 1) {
       return -1;
     }
+    if (comp_changed || !leaving_vs.empty()) {
+      normalizeComp(data, edge_index);
+    }
     assert(level - 1 > 0);
     return level - 1;
   }
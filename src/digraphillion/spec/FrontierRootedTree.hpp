@@ -53,7 +53,10 @@ class FrontierRootedTreeSpec
 
   const bool isSpanning_;
 
-  const FrontierManager fm_;
+  // frontier manager shared by the specs built on graph_
+  const FrontierManager& fm_;
+  // frontier lists of the edge being processed, rebuilt from fm_
+  mutable FrontierCursor cursor_;
 
   // This function gets deg of v.
   short getIndeg(DirectedFrontierData* data, short v) const {
@@ -88,6 +91,16 @@ class FrontierRootedTreeSpec
     data[fm_.vertexToPos(v)].comp = c;
   }
 
+  // This function renumbers comp of the vertices remaining on the frontier
+  // after the (edge_index)-th edge is processed (see
+  // FrontierManager::normalizeComp).
+  void normalizeComp(DirectedFrontierData* data, int edge_index) const {
+    fm_.normalizeComp(
+        cursor_.getRemainingVs(edge_index),
+        [&](int v) { return getComp(data, v); },
+        [&](int v, int c) { setComp(data, v, static_cast<ushort>(c)); });
+  }
+
   void initializeData(DirectedFrontierData* data) const {
     for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
       data[i].indeg = 0;
@@ -96,21 +109,41 @@ class FrontierRootedTreeSpec
     }
   }
 
+  // This function returns false if the edges remaining after the
+  // (edge_index)-th edge can no longer supply the degree v needs.  In a
+  // spanning tree, the root needs an outgoing edge and the other vertices
+  // need an incoming one; otherwise a vertex other than the root needs an
+  // incoming edge if it has an outgoing one.
+  bool isDegreeFeasible(DirectedFrontierData* data, short v,
+                        int edge_index) const {
+    if (v == root_) {
+      return !isSpanning_ || getOutdeg(data, v) > 0 ||
+             fm_.getRemainingOutdeg(edge_index, v) > 0;
+    }
+    if (getIndeg(data, v) > 0 || fm_.getRemainingIndeg(edge_index, v) > 0) {
+      return true;
+    }
+    return !isSpanning_ && getOutdeg(data, v) == 0;
+  }
+
  public:
-  FrontierRootedTreeSpec(const tdzdd::Digraph& graph, ushort root,
+  FrontierRootedTreeSpec(const tdzdd::Digraph& graph,
+                         const FrontierManager& fm, ushort root,
                          bool isSpanning)
       : graph_(graph),
         n_(graph_.vertexSize()),
         m_(graph_.edgeSize()),
         root_(root),
         isSpanning_(isSpanning),
-        fm_(graph_) {
+        fm_(fm),
+        cursor_(fm) {
     if (n_ >= (1 << 15)) {
       std::cerr << "The number of vertices must be smaller than 2^15."
                 << std::endl;
       exit(1);
     }
     setArraySize(fm_.getMaxFrontierSize());
+    setLevelArraySizes(fm_.getStateWidthsByLevel());
   }
 
   int getRoot(DirectedFrontierData* data) const {
@@ -128,16 +161,19 @@ class FrontierRootedTreeSpec
     const Digraph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
 
     // initialize deg and comp of the vertices newly entering the frontier
-    const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+    const VertexList entering_vs = fm_.getEnteringVs(edge_index);
     for (size_t i = 0; i < entering_vs.size(); ++i) {
       int v = entering_vs[i];
-      // initially the value of comp is the vertex number itself
+      // initially the value of comp is the position of the vertex itself
       resetDeg(data, v);
-      setComp(data, v, static_cast<ushort>(v));
+      setComp(data, v, static_cast<ushort>(fm_.vertexToPos(v)));
     }
 
     // vertices on the frontier
-    const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
+    const VertexList frontier_vs = cursor_.getFrontierVs(edge_index);
+
+    // whether comp of some vertices may be no longer normalized
+    bool comp_changed = false;
 
     if (value == 1) {  // if we take the edge (go to 1-arc)
       ushort c1 = getComp(data, edge.v1);
@@ -154,6 +190,7 @@ class FrontierRootedTreeSpec
       setOutdeg(data, edge.v1, outdeg1 + 1);
 
       if (c1 != c2) {  // connected components c1 and c2 become connected
+        comp_changed = true;
         ushort cmin = std::min(c1, c2);
         ushort cmax = std::max(c1, c2);
 
@@ -167,8 +204,15 @@ class FrontierRootedTreeSpec
       }
     }
 
+    // The degrees of the endpoints are checked against the edges that
+    // remain, since the other vertices are not changed by this edge.
+    if (!isDegreeFeasible(data, edge.v1, edge_index) ||
+        !isDegreeFeasible(data, edge.v2, edge_index)) {
+      return 0;
+    }
+
     // vertices that are leaving the frontier
-    const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+    const VertexList leaving_vs = fm_.getLeavingVs(edge_index);
     for (size_t i = 0; i < leaving_vs.size(); ++i) {
       int v = leaving_vs[i];
 
@@ -281,6 +325,9 @@ class FrontierRootedTreeSpec
       return -1;  // return the 1-terminal
     }
 
+    if (comp_changed || !leaving_vs.empty()) {
+      normalizeComp(data, edge_index);
+    }
     assert(level - 1 > 0);
     return level - 1;
   }
@@ -0,0 +1,254 @@
+/**
+Copyright (c) 2021 ComputerAlgorithmsGroupAtKyotoU
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SPEC_ESTIMATOR_HPP
+#define SPEC_ESTIMATOR_HPP
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "subsetting/util/ResourceUsage.hpp"
+
+// This class estimates the number of the nodes that DdBuilder creates
+// for a spec, including the dead nodes swept later, without building the
+// whole DD.  The states are expanded level by level as in DdBuilder, but
+// at most width_limit states are expanded at each level.  If a level has
+// more states, a random sample of them is expanded, and the number of the
+// states at the next levels is extrapolated from the number of the arcs
+// that the sample generates and how many of them are merged, assuming
+// that the arcs point to states drawn uniformly from an unknown pool.
+// The estimate is exact when no level exceeds width_limit.  Otherwise it
+// tends to be low, since a sample keeps siblings, which are merged more
+// often than states drawn uniformly.
+template <typename S>
+class SpecEstimator {
+ private:
+  typedef uint64_t Word;
+
+  // the states generated at a level, which are merged by
+  // hash_code/equal_to and stored in a flat array
+  struct Level {
+    std::vector<Word> states;
+    size_t size;
+    std::vector<int> table;  // open addressing; -1 means an empty slot
+
+    // the number of the arcs pointing to the level generated by the
+    // expanded states, and that extrapolated to all the states
+    double arcs;
+    double full_arcs;
+
+    Level() : size(0), arcs(0), full_arcs(0) {}
+  };
+
+  S spec_;
+  const int words_;
+
+  std::vector<Level> levels_;
+
+  // node_counts_[level] is the estimated number of the nodes at the level
+  std::vector<double> node_counts_;
+  double expanded_nodes_;
+  double seconds_;
+  bool exact_;
+
+  // xorshift64 for sampling, seeded by a constant for reproducibility
+  uint64_t random_;
+
+  uint64_t nextRandom() {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    return random_;
+  }
+
+  Word* state(Level& lv, size_t j) { return &lv.states[j * words_]; }
+
+  // This function returns the slot of the state p in a table of the size,
+  // taking the upper bits of the hash code mixed by multiplication.
+  size_t slot(const Word* p, int level, size_t size) const {
+    uint64_t h = spec_.hash_code(p, level) * 0x9E3779B97F4A7C15ULL;
+    return (h ^ (h >> 32)) & (size - 1);
+  }
+
+  void rehash(Level& lv, int level) {
+    size_t size = 16;
+    while (size < (lv.size + 1) * 4) size *= 2;
+    lv.table.assign(size, -1);
+    const size_t mask = size - 1;
+    for (size_t j = 0; j < lv.size; ++j) {
+      size_t h = slot(state(lv, j), level, size);
+      while (lv.table[h] >= 0) h = (h + 1) & mask;
+      lv.table[h] = j;
+    }
+  }
+
+  // This function adds the state p to the level unless an equivalent
+  // state is there, in which case p is destructed.  The memory of p is
+  // reused by the caller in either case.
+  void insert(Word* p, int level) {
+    Level& lv = levels_[level];
+    if (lv.table.size() < (lv.size + 1) * 2) rehash(lv, level);
+    const size_t mask = lv.table.size() - 1;
+    size_t h = slot(p, level, mask + 1);
+    while (lv.table[h] >= 0) {
+      if (spec_.equal_to(state(lv, lv.table[h]), p, level)) {
+        spec_.destruct(p);
+        return;
+      }
+      h = (h + 1) & mask;
+    }
+    lv.table[h] = lv.size;
+    lv.states.insert(lv.states.end(), p, p + words_);
+    ++lv.size;
+  }
+
+  // This function returns the estimated number of the distinct states
+  // pointed to by full_arcs arcs, when arcs of them result in distinct
+  // states.  The pool size k is the solution of k (1 - e^{-arcs / k})
+  // = distinct, which is found by bisection.
+  static double extrapolate(double distinct, double arcs, double full_arcs) {
+    if (distinct >= arcs || full_arcs <= arcs) return distinct;
+    double lo = distinct;
+    double hi = distinct;
+    while (hi * -std::expm1(-arcs / hi) < distinct) hi *= 2;
+    for (int k = 0; k < 64; ++k) {
+      double mid = (lo + hi) / 2;
+      if (mid * -std::expm1(-arcs / mid) < distinct) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    return std::max(distinct, hi * -std::expm1(-full_arcs / hi));
+  }
+
+  // This function keeps a random sample of width_limit states at the
+  // level.
+  void sample(Level& lv, int width_limit) {
+    std::vector<Word> tmp(words_);
+    for (size_t j = 0; j < static_cast<size_t>(width_limit); ++j) {
+      size_t k = j + nextRandom() % (lv.size - j);
+      std::swap_ranges(state(lv, j), state(lv, j) + words_, tmp.begin());
+      std::copy(state(lv, k), state(lv, k) + words_, state(lv, j));
+      std::copy(tmp.begin(), tmp.end(), state(lv, k));
+    }
+    for (size_t j = width_limit; j < lv.size; ++j) {
+      spec_.destruct(state(lv, j));
+    }
+    lv.size = width_limit;
+    lv.states.resize(lv.size * words_);
+  }
+
+  void clear(Level& lv) {
+    for (size_t j = 0; j < lv.size; ++j) spec_.destruct(state(lv, j));
+    std::vector<Word>().swap(lv.states);
+    std::vector<int>().swap(lv.table);
+    lv.size = 0;
+  }
+
+ public:
+  explicit SpecEstimator(const S& spec)
+      : spec_(spec),
+        words_(std::max(1, (spec_.datasize() + 7) / 8)),
+        expanded_nodes_(0),
+        seconds_(0),
+        exact_(true),
+        random_(88172645463325252ULL) {}
+
+  ~SpecEstimator() {
+    for (size_t level = 0; level < levels_.size(); ++level) {
+      clear(levels_[level]);
+    }
+  }
+
+  // This function runs the sampled build.
+  void run(int width_limit) {
+    assert(width_limit >= 1);
+    tdzdd::ResourceUsage start;
+
+    std::vector<Word> tmp(words_);
+    const int top = spec_.get_root(&tmp[0]);
+    levels_.resize(std::max(top, 0) + 1);
+    node_counts_.assign(levels_.size(), 0);
+    if (top <= 0) {
+      spec_.destruct(&tmp[0]);
+      return;
+    }
+    insert(&tmp[0], top);
+    levels_[top].arcs = levels_[top].full_arcs = 1;
+
+    for (int level = top; level >= 1; --level) {
+      Level& lv = levels_[level];
+      if (lv.size == 0) continue;
+      const double count = extrapolate(lv.size, lv.arcs, lv.full_arcs);
+      node_counts_[level] = count;
+      if (lv.size > static_cast<size_t>(width_limit)) {
+        sample(lv, width_limit);
+        exact_ = false;
+      }
+      if (count > lv.size) exact_ = false;
+      // each expanded state stands for this number of states
+      const double weight = count / lv.size;
+
+      std::vector<int>().swap(lv.table);
+      for (size_t j = 0; j < lv.size; ++j) {
+        for (int b = 0; b < 2; ++b) {
+          spec_.get_copy(&tmp[0], state(lv, j));
+          int child = spec_.get_child(&tmp[0], level, b);
+          if (child > 0) {
+            assert(child < level);
+            levels_[child].arcs += 1;
+            levels_[child].full_arcs += weight;
+            insert(&tmp[0], child);
+          } else {
+            spec_.destruct(&tmp[0]);
+          }
+        }
+      }
+      expanded_nodes_ += lv.size;
+      clear(lv);
+      spec_.destructLevel(level);
+    }
+    seconds_ = (tdzdd::ResourceUsage() - start).etime;
+  }
+
+  // This function returns the estimated number of the nodes at each level.
+  const std::vector<double>& nodeCounts() const { return node_counts_; }
+
+  // This function returns the number of the nodes actually expanded.
+  double expandedNodes() const { return expanded_nodes_; }
+
+  // This function returns the time spent in run() in seconds.
+  double seconds() const { return seconds_; }
+
+  // This function returns true if no level was sampled.
+  bool isExact() const { return exact_; }
+
+  // This function returns the size of the states stored at the level.
+  int datasize(int level) const { return spec_.datasize_at_level(level); }
+};
+
+#endif  // SPEC_ESTIMATOR_HPP
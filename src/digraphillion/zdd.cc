@@ -21,16 +21,21 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "digraphillion/zdd.h"
 
+#include <stdint.h>
+
 #include <algorithm>
 #include <climits>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <string>
 
 #include "digraphillion/util.h"
+#include "subsetting/util/BigNumber.hpp"
+#include "subsetting/util/Threads.hpp"
 
 namespace digraphillion {
 
-using std::binary_search;
 using std::endl;
 using std::getline;
 using std::istream;
@@ -51,6 +56,15 @@ static elem_t max_elem_ = 0;
 // size of universe, which must not be larger than max_elem_
 static elem_t num_elems_ = 0;
 
+// the power set of the universe, which is built by universe() and
+// released when num_elems_ is changed
+static zdd_t universe_ = null();
+
+// operation codes for the caches of hitting(), which must not conflict
+// with those used in SAPPOROBDD
+static const char BC_HITTING = 74;
+static const char BC_DONT_CARE = 75;
+
 ZBDD operator|(const ZBDD& f, const ZBDD& g) { return f + g; }
 
 void init() {
@@ -69,7 +83,10 @@ elem_t max_elem() {
 void new_elems(elem_t max_elem) {
   assert(max_elem <= elem_limit());
   if (!initialized_) init();
-  if (num_elems_ < max_elem) num_elems_ = max_elem;
+  if (num_elems_ < max_elem) {
+    num_elems_ = max_elem;
+    universe_ = null();
+  }
   while (max_elem_ < max_elem) {
     top().Change(BDD_NewVarOfLev(1));
     num_elems_ = ++max_elem_;
@@ -85,6 +102,7 @@ elem_t num_elems() {
 
 void num_elems(elem_t num_elems) {
   new_elems(num_elems);
+  if (num_elems_ != num_elems) universe_ = null();
   num_elems_ = num_elems;
   assert(num_elems_ <= max_elem_);
 }
@@ -95,212 +113,82 @@ zdd_t single(elem_t e) {
   return top().Change(e);
 }
 
+zdd_t universe() {
+  if (universe_ == null()) {
+    universe_ = top();
+    for (elem_t v = num_elems_; v > 0; --v)
+      universe_ = ZBDD_Node(v, universe_, universe_);
+  }
+  return universe_;
+}
+
+// The complement is given by bddc without building the universe, whose
+// variables are at the top num_elems_ levels.
 zdd_t complement(zdd_t f) {
-  vector<zdd_t> n(num_elems_ + 2);
-  n[0] = bot(), n[1] = top();
-  for (elem_t v = num_elems_; v > 0; --v) {
-    elem_t i = num_elems_ - v + 2;
-    n[i] = n[i - 1] + single(v) * n[i - 1];
-  }
-  return n[num_elems_ + 1] - f;
-}
-
-zdd_t minimal(zdd_t f) {
-  static map<word_t, zdd_t> cache;
-  if (is_term(f)) return f;
-  map<word_t, zdd_t>::iterator i = cache.find(id(f));
-  if (i != cache.end()) return i->second;
-  zdd_t rl = minimal(lo(f));
-  zdd_t r = minimal(hi(f));
-  zdd_t rh = non_supersets(r, rl);
-  r = zuniq(elem(f), rl, rh);
-  return cache[id(f)] = r;
-}
-
-zdd_t maximal(zdd_t f) {
-  static map<word_t, zdd_t> cache;
-  if (is_term(f)) return f;
-  map<word_t, zdd_t>::iterator i = cache.find(id(f));
-  if (i != cache.end()) return i->second;
-  zdd_t r = maximal(lo(f));
-  zdd_t rh = maximal(hi(f));
-  zdd_t rl = non_subsets(r, rh);
-  r = zuniq(elem(f), rl, rh);
-  return cache[id(f)] = r;
+  if (f == bot()) return universe();
+  return ZBDD_Complement(f, max_elem_ - num_elems_);
 }
 
+zdd_t minimal(zdd_t f) { return ZBDD_Minimal(f); }
+
+zdd_t maximal(zdd_t f) { return ZBDD_Maximal(f); }
+
+// This function returns f with elements v, ..., elem(f) - 1 made
+// don't-care, i.e., the sets over v, ..., num_elems_ whose intersections
+// with elem(f), ..., num_elems_ are in f.  The nodes of the chain are
+// cached, so the chains of the nodes sharing f are built only once.
+static zdd_t dont_care(zdd_t f, elem_t v) {
+  if (f == bot()) return f;
+  const elem_t t = is_term(f) ? num_elems_ + 1 : elem(f);
+  // the chain of a terminal depends on num_elems_, so it is in the key
+  const word_t n = static_cast<word_t>(elem_limit()) + 1;
+  elem_t j = v;
+  zdd_t g = f;
+  for (; j < t; ++j) {
+    g = BDD_CacheZBDD(BC_DONT_CARE, id(f), j * n + num_elems_);
+    if (g != null()) break;
+  }
+  if (j == t) g = f;
+  while (j > v) {
+    --j;
+    g = ZBDD_Node(j, g, g);
+    BDD_CacheEnt(BC_DONT_CARE, id(f), j * n + num_elems_, id(g));
+  }
+  return g;
+}
+
+// This function returns the sets over 1, ..., num_elems_ that intersect
+// all the sets in f.  The hitting sets of the nodes are found bottom-up,
+// where those of each node are over elem() and the following elements.
 zdd_t hitting(zdd_t f) {
   if (f == bot()) return top();
-  if (f == top()) return bot();
-  vector<vector<zdd_t> > stacks(num_elems_ + 1);
-  set<word_t> visited;
-  sort_zdd(f, &stacks, &visited);
-  map<word_t, zdd_t> cache;
-  cache[id(bot())] = bot();
-  cache[id(top())] = bot();
-  for (elem_t v = num_elems_; v > 0; --v) {
-    while (!stacks[v].empty()) {
-      zdd_t n = stacks[v].back();
-      stacks[v].pop_back();
-      zdd_t l = cache.at(id(lo(n)));
-      if (lo(n) != bot()) {
-        elem_t j = lo(n) == top() ? num_elems_ : elem(lo(n)) - 1;
-        for (; j > v; --j) l = l + l.Change(j);
-      }
-      zdd_t h = cache.at(id(hi(n)));
-      if (hi(n) != bot()) {
-        elem_t j = hi(n) == top() ? num_elems_ : elem(hi(n)) - 1;
-        for (; j > v; --j) h = h + h.Change(j);
-      }
-      if (lo(n) == bot()) {
-        zdd_t g = top();
-        for (elem_t j = num_elems_; j > v; --j) g = g + g.Change(j);
-        g = g.Change(elem(n));
-        cache[id(n)] = h + g;
-      } else {
-        cache[id(n)] = (h & l) + l.Change(v);
-      }
+  zdd_nodes n(f);
+  vector<zdd_t> rs(n.size());
+  rs[0] = top();  // every set hits all the sets in bot()
+  rs[1] = bot();  // no set hits the empty set
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    zdd_t r = BDD_CacheZBDD(BC_HITTING, n.id(i), num_elems_);
+    if (r == null()) {
+      elem_t u = n.elem(i);
+      zdd_t l = dont_care(rs[n.lo(i)], u + 1);
+      zdd_t h = dont_care(rs[n.hi(i)], u + 1);
+      // a set without u must hit both the sets with u and without u,
+      // while a set with u must hit only the sets without u
+      r = ZBDD_Node(u, n.lo(i) == 0 ? h : h & l, l);
+      BDD_CacheEnt(BC_HITTING, n.id(i), num_elems_, id(r));
     }
+    rs[i] = r;
   }
-  zdd_t g = cache.at(id(f));
-  elem_t j = is_term(f) ? num_elems_ : elem(f) - 1;
-  for (; j > 0; --j) g = g + g.Change(j);
-  return g;
+  return dont_care(rs[n.root()], 1);
 }
 
 zdd_t join(zdd_t f, zdd_t g) { return f * g; }
 
 zdd_t meet(zdd_t f, zdd_t g) { return ZBDD_Meet(f, g); }
 
-zdd_t non_subsets(zdd_t f, zdd_t g) {
-  static map<pair<word_t, word_t>, zdd_t> cache;
-  if (g == bot())
-    return f;
-  else if (g == top())
-    return f - top();
-  else if (f == bot() || f == top() || f == g)
-    return bot();
-  pair<word_t, word_t> k = make_key(f, g);
-  map<pair<word_t, word_t>, zdd_t>::iterator i = cache.find(k);
-  if (i != cache.end()) return i->second;
-  zdd_t r, r2, rl, rh;
-  if (elem(f) < elem(g)) {
-    rl = non_subsets(lo(f), g);
-    rh = hi(f);
-    r = zuniq(elem(f), rl, rh);
-  } else if (elem(f) == elem(g)) {
-    //    r = non_subsets(lo(f), lo(g));
-    //    r2 = non_subsets(lo(f), hi(g));
-    //    rl = r & r2;
-    r2 = lo(g) | hi(g);
-    rl = non_subsets(lo(f), r2);
-    rh = non_subsets(hi(f), hi(g));
-    r = zuniq(elem(f), rl, rh);
-  } else {
-    r2 = lo(g) | hi(g);
-    r = non_subsets(f, r2);
-  }
-  return cache[k] = r;
-}
+zdd_t non_subsets(zdd_t f, zdd_t g) { return ZBDD_NonSubsets(f, g); }
 
-zdd_t non_supersets(zdd_t f, zdd_t g) {
-  static map<pair<word_t, word_t>, zdd_t> cache;
-  if (g == bot())
-    return f;
-  else if (f == bot() || g == top() || f == g)
-    return bot();
-  else if (f == top())
-    return top();
-  else if (elem(f) > elem(g))
-    return non_supersets(f, lo(g));
-  pair<word_t, word_t> k = make_key(f, g);
-  map<pair<word_t, word_t>, zdd_t>::iterator i = cache.find(k);
-  if (i != cache.end()) return i->second;
-  elem_t v = elem(f);
-  zdd_t r;
-  zdd_t rl;
-  zdd_t rh;
-  if (elem(f) < elem(g)) {
-    rl = non_supersets(lo(f), g);
-    rh = non_supersets(hi(f), g);
-  } else {
-    rl = non_supersets(hi(f), hi(g));
-    r = non_supersets(hi(f), lo(g));
-    rh = r & rl;
-    rl = non_supersets(lo(f), lo(g));
-  }
-  r = zuniq(v, rl, rh);
-  return cache[k] = r;
-}
-
-bool choose(zdd_t f, vector<elem_t>* stack) {
-  assert(stack != NULL);
-  int last = stack->size() - 1;
-  if (f == bot())
-    return false;
-  else if (f == top())
-    return true;
-  // if elem(f) > any in stack
-  if (last < 0 || elem(f) > (*stack)[last]) {
-    stack->push_back(elem(f));
-    if (choose(hi(f), stack)) return true;
-  } else {
-    // if elem(f) in stack
-    if (binary_search(stack->begin(), stack->end(), elem(f))) {
-      // if not elem(f) is last element in stack
-      if (elem(f) != (*stack)[last] && choose(hi(f), stack)) return true;
-    } else {
-      // if elem(f) not in stack
-      if (lo(f) != bot() && choose(lo(f), stack)) return true;
-      return false;
-    }
-  }
-  // fail in hi(f) and try lo(f)
-  last = stack->size() - 1;
-  // if elem(f) is last element in stack
-  if (last >= 0 && elem(f) == (*stack)[last]) {
-    stack->pop_back();
-    if (lo(f) != bot() && choose(lo(f), stack)) return true;
-  }
-  return false;
-}
-
-zdd_t choose_random(zdd_t f, vector<elem_t>* stack) {
-  assert(stack != NULL);
-  if (is_term(f)) {
-    if (f == top()) {
-      zdd_t g = top();
-      for (int i = 0; i <= static_cast<int>(stack->size()) - 1; i++)
-        g = g * single((*stack)[i]);
-      return g;
-    }
-    assert(false);
-  }
-  double ch = algo_c(hi(f));
-  double cl = algo_c(lo(f));
-  if (rand_xor128() > cl / (ch + cl)) {
-    stack->push_back(elem(f));
-    return choose_random(hi(f), stack);
-  } else {
-    return choose_random(lo(f), stack);
-  }
-}
-
-zdd_t choose_best(zdd_t f, const vector<double>& weights, set<elem_t>* s) {
-  assert(s != NULL);
-  if (f == bot()) return bot();
-  vector<bool> x;
-  algo_b(f, weights, &x);
-  zdd_t g = top();
-  s->clear();
-  for (elem_t j = 1; j < static_cast<elem_t>(x.size()); j++) {
-    if (x[j]) {
-      g = g * single(j);
-      s->insert(j);
-    }
-  }
-  return g;
-}
+zdd_t non_supersets(zdd_t f, zdd_t g) { return ZBDD_NonSupersets(f, g); }
 
 void dump(zdd_t f, ostream& out) {
   if (f == bot()) {
@@ -308,29 +196,25 @@ void dump(zdd_t f, ostream& out) {
   } else if (f == top()) {
     out << "T" << endl;
   } else {
-    vector<vector<zdd_t> > stacks(num_elems_ + 1);
-    set<word_t> visited;
-    sort_zdd(f, &stacks, &visited);
-    for (elem_t v = num_elems_; v > 0; --v) {
-      while (!stacks[v].empty()) {
-        zdd_t g = stacks[v].back();
-        stacks[v].pop_back();
-        zdd_t l = lo(g);
-        zdd_t h = hi(g);
-        out << id(g) << " " << elem(g) << " ";
-        if (l == bot())
+    zdd_nodes n(f);
+    for (elem_t v = n.max_elem(); v > 0; --v) {
+      for (zdd_nodes::index_t i = n.end(v); i > n.begin(v); --i) {
+        zdd_nodes::index_t l = n.lo(i - 1);
+        zdd_nodes::index_t h = n.hi(i - 1);
+        out << n.id(i - 1) << " " << v << " ";
+        if (l == 0)
           out << "B";
-        else if (l == top())
+        else if (l == 1)
           out << "T";
         else
-          out << id(l);
+          out << n.id(l);
         out << " ";
-        if (h == bot())
+        if (h == 0)
           out << "B";
-        else if (h == top())
+        else if (h == 1)
           out << "T";
         else
-          out << id(h);
+          out << n.id(h);
         out << endl;
       }
     }
@@ -344,29 +228,25 @@ void dump(zdd_t f, FILE* fp) {
   } else if (f == top()) {
     fprintf(fp, "T\n");
   } else {
-    vector<vector<zdd_t> > stacks(num_elems_ + 1);
-    set<word_t> visited;
-    sort_zdd(f, &stacks, &visited);
-    for (elem_t v = num_elems_; v > 0; --v) {
-      while (!stacks[v].empty()) {
-        zdd_t g = stacks[v].back();
-        stacks[v].pop_back();
-        zdd_t l = lo(g);
-        zdd_t h = hi(g);
-        fprintf(fp, (WORD_FMT + " %d ").c_str(), id(g), elem(g));
-        if (l == bot())
+    zdd_nodes n(f);
+    for (elem_t v = n.max_elem(); v > 0; --v) {
+      for (zdd_nodes::index_t i = n.end(v); i > n.begin(v); --i) {
+        zdd_nodes::index_t l = n.lo(i - 1);
+        zdd_nodes::index_t h = n.hi(i - 1);
+        fprintf(fp, (WORD_FMT + " %d ").c_str(), n.id(i - 1), v);
+        if (l == 0)
           fprintf(fp, "B");
-        else if (l == top())
+        else if (l == 1)
           fprintf(fp, "T");
         else
-          fprintf(fp, WORD_FMT.c_str(), id(l));
+          fprintf(fp, WORD_FMT.c_str(), n.id(l));
         fprintf(fp, " ");
-        if (h == bot())
+        if (h == 0)
           fprintf(fp, "B");
-        else if (h == top())
+        else if (h == 1)
           fprintf(fp, "T");
         else
-          fprintf(fp, WORD_FMT.c_str(), id(h));
+          fprintf(fp, WORD_FMT.c_str(), n.id(h));
         fprintf(fp, "\n");
       }
     }
@@ -505,81 +385,300 @@ void _enum(zdd_t f, FILE* fp, vector<elem_t>* stack, bool* first,
   _enum(lo(f), fp, stack, first, inner_braces);
 }
 
-// Algorithm B modified for ZDD, from Knuth vol. 4 fascicle 1 sec. 7.1.4.
-void algo_b(zdd_t f, const vector<double>& w, vector<bool>* x) {
-  assert(x != NULL);
-  assert(f != bot());
-  if (f == top()) return;
-  vector<vector<zdd_t> > stacks(num_elems_ + 1);
-  set<word_t> visited;
-  elem_t max_elem = 0;
-  sort_zdd(f, &stacks, &visited, &max_elem);
-  assert(w.size() > static_cast<size_t>(max_elem));
-  x->clear();
-  x->resize(max_elem + 1, false);
-  map<word_t, bool> t;
-  map<word_t, double> ms;
-  ms[id(bot())] = INT_MIN;
-  ms[id(top())] = 0;
-  for (elem_t v = max_elem; v > 0; --v) {
-    while (!stacks[v].empty()) {
-      zdd_t g = stacks[v].back();
-      stacks[v].pop_back();
-      word_t k = id(g);
-      elem_t v = elem(g);
-      word_t l = id(lo(g));
-      word_t h = id(hi(g));
-      if (lo(g) != bot()) ms[k] = ms.at(l);
-      if (hi(g) != bot()) {
-        double m = ms.at(h) + w[v];
-        if (lo(g) == bot() || m > ms.at(k)) {
-          ms[k] = m;
-          t[k] = true;
+// This function counts the sets exactly, where the counts of the nodes of
+// each element are packed in a flat array, whose width is enough for the
+// elements below, and the nodes of an element are counted in parallel.
+// The counts of an element are released once all the parents are counted.
+string count(zdd_t f) {
+  if (is_term(f)) return f == top() ? "1" : "0";
+  zdd_nodes n(f);
+  const elem_t m = n.max_elem();
+  vector<elem_t> last(m + 1, m + 1);  // the smallest element of the parents
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    zdd_nodes::index_t c[2] = {n.lo(i), n.hi(i)};
+    for (int k = 0; k < 2; ++k)
+      if (!n.is_term(c[k]))
+        last[n.elem(c[k])] = std::min(last[n.elem(c[k])], n.elem(i));
+  }
+
+  const uint64_t terms[2] = {0, 1};
+  vector<vector<uint64_t> > counts(m + 1);
+  vector<int> widths(m + 1);
+  for (elem_t v = m; v > 0; --v) {
+    const intmax_t b = n.begin(v);
+    const intmax_t e = n.end(v);
+    const int w = widths[v] = tdzdd::PackedBigNumber::words(m - v + 1);
+    counts[v].resize((e - b) * w);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(tdzdd::maxThreads()) \
+    if ((e - b) * w >= 4096)
+#endif
+    for (intmax_t i = b; i < e; ++i) {
+      uint64_t* p = &counts[v][(i - b) * w];
+      zdd_nodes::index_t c[2] = {n.lo(i), n.hi(i)};
+      for (int k = 0; k < 2; ++k) {
+        if (n.is_term(c[k])) {
+          tdzdd::PackedBigNumber::add(p, w, &terms[c[k]], 1);
+        } else {
+          elem_t u = n.elem(c[k]);
+          tdzdd::PackedBigNumber::add(
+              p, w, &counts[u][(c[k] - n.begin(u)) * widths[u]], widths[u]);
+        }
+      }
+    }
+    for (elem_t u = v + 1; u <= m; ++u)
+      if (last[u] == v) vector<uint64_t>().swap(counts[u]);
+  }
+  elem_t v = n.elem(n.root());
+  return tdzdd::PackedBigNumber::toString(
+      &counts[v][(n.root() - n.begin(v)) * widths[v]], widths[v]);
+}
+
+// This function gives the smallest and the largest sizes of the sets in
+// the nodes, which are undefined for bot().
+static void set_sizes(const zdd_nodes& n, vector<int>* mins,
+                      vector<int>* maxs) {
+  mins->assign(n.size(), 0);
+  maxs->assign(n.size(), 0);
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    zdd_nodes::index_t l = n.lo(i), h = n.hi(i);
+    (*mins)[i] = (*mins)[h] + 1;
+    (*maxs)[i] = (*maxs)[h] + 1;
+    if (l != 0) {
+      (*mins)[i] = std::min((*mins)[i], (*mins)[l]);
+      (*maxs)[i] = std::max((*maxs)[i], (*maxs)[l]);
+    }
+  }
+}
+
+struct SizeWindow {
+  int lower;
+  int upper;
+  zdd_t f;
+};
+
+// This function returns the sets of the i-th node whose sizes are in
+// [lower, upper].  The window is narrowed to the sizes in the node, so
+// the node is returned as it is if all the sets fit, and the results are
+// kept for each narrowed window, which are few for a node.
+static zdd_t size_window(const zdd_nodes& n, zdd_nodes::index_t i, int lower,
+                         int upper, const vector<int>& mins,
+                         const vector<int>& maxs,
+                         vector<vector<SizeWindow> >* memo) {
+  if (i == 0) return bot();
+  lower = std::max(lower, mins[i]);
+  upper = std::min(upper, maxs[i]);
+  if (lower > upper) return bot();
+  if (lower == mins[i] && upper == maxs[i]) return ZBDD_ID(bddcopy(n.id(i)));
+  vector<SizeWindow>& ws = (*memo)[i];
+  for (vector<SizeWindow>::const_iterator w = ws.begin(); w != ws.end(); ++w)
+    if (w->lower == lower && w->upper == upper) return w->f;
+  zdd_t l = size_window(n, n.lo(i), lower, upper, mins, maxs, memo);
+  zdd_t h = size_window(n, n.hi(i), lower - 1, upper - 1, mins, maxs, memo);
+  SizeWindow w = {lower, upper, ZBDD_Node(n.elem(i), l, h)};
+  ws.push_back(w);
+  return w.f;
+}
+
+// This function returns the sets in f whose sizes are in [lower, upper]
+// in a single pass over the nodes.
+zdd_t size_window(zdd_t f, int lower, int upper) {
+  if (lower > upper || f == bot()) return bot();
+  zdd_nodes n(f);
+  vector<int> mins, maxs;
+  set_sizes(n, &mins, &maxs);
+  vector<vector<SizeWindow> > memo(n.size());
+  return size_window(n, n.root(), lower, upper, mins, maxs, &memo);
+}
+
+// This function counts the sets of each size exactly in a bottom-up pass,
+// where each node has the counts for the sizes of its sets as count(),
+// which are packed in a flat array for each element.
+void size_histogram(zdd_t f, vector<string>* counts) {
+  assert(counts != NULL);
+  counts->clear();
+  if (f == bot()) return;
+  if (f == top()) {
+    counts->push_back("1");
+    return;
+  }
+  zdd_nodes n(f);
+  vector<int> mins, maxs;
+  set_sizes(n, &mins, &maxs);
+  const elem_t m = n.max_elem();
+  vector<elem_t> last(m + 1, m + 1);  // the smallest element of the parents
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    zdd_nodes::index_t c[2] = {n.lo(i), n.hi(i)};
+    for (int k = 0; k < 2; ++k)
+      if (!n.is_term(c[k]))
+        last[n.elem(c[k])] = std::min(last[n.elem(c[k])], n.elem(i));
+  }
+
+  // the counts of the i-th node for sizes mins[i], ..., maxs[i] begin at
+  // offsets[i] in the array of its element
+  const uint64_t one = 1;
+  vector<size_t> offsets(n.size());
+  vector<vector<uint64_t> > words(m + 1);
+  vector<int> widths(m + 1);
+  for (elem_t v = m; v > 0; --v) {
+    const intmax_t b = n.begin(v);
+    const intmax_t e = n.end(v);
+    const int w = widths[v] = tdzdd::PackedBigNumber::words(m - v + 1);
+    size_t size = 0;
+    for (intmax_t i = b; i < e; ++i) {
+      offsets[i] = size;
+      size += (maxs[i] - mins[i] + 1) * w;
+    }
+    words[v].resize(size);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(tdzdd::maxThreads()) \
+    if (size >= 4096)
+#endif
+    for (intmax_t i = b; i < e; ++i) {
+      zdd_nodes::index_t c[2] = {n.lo(i), n.hi(i)};
+      for (int k = 0; k < 2; ++k) {
+        if (c[k] == 0) continue;
+        // the sets of hi() have one more element
+        uint64_t* p = &words[v][offsets[i] + (mins[c[k]] + k - mins[i]) * w];
+        if (c[k] == 1) {
+          tdzdd::PackedBigNumber::add(p, w, &one, 1);
+          continue;
         }
+        elem_t u = n.elem(c[k]);
+        const int cw = widths[u];
+        const uint64_t* q = &words[u][offsets[c[k]]];
+        for (int s = mins[c[k]]; s <= maxs[c[k]]; ++s, p += w, q += cw)
+          tdzdd::PackedBigNumber::add(p, w, q, cw);
       }
     }
+    for (elem_t u = v + 1; u <= m; ++u)
+      if (last[u] == v) vector<uint64_t>().swap(words[u]);
+  }
+
+  zdd_nodes::index_t r = n.root();
+  elem_t v = n.elem(r);
+  counts->assign(maxs[r] + 1, "0");
+  for (int s = mins[r]; s <= maxs[r]; ++s) {
+    (*counts)[s] = tdzdd::PackedBigNumber::toString(
+        &words[v][offsets[r] + (s - mins[r]) * widths[v]], widths[v]);
   }
-  while (!is_term(f)) {
-    word_t k = id(f);
-    elem_t v = elem(f);
-    if (t.find(k) == t.end()) t[k] = false;
-    (*x)[v] = t.at(k);
-    f = !t.at(k) ? lo(f) : hi(f);
+}
+
+// The products of 1 - p over the elements before each element, which are
+// kept as mantissas and exponents so as not to underflow.  The zero factors
+// are counted apart, so the product over e, ..., t - 1 is a division.
+struct SkipProducts {
+  vector<double> m;
+  vector<int> e;
+  vector<int> zeros;
+};
+
+// This function builds the products for the lanes of ps, where
+// ps[v * lanes + b] is the probability of element v in lane b.
+static void skip_products(const vector<double>& ps, int lanes,
+                          SkipProducts* products) {
+  const elem_t m = num_elems();
+  products->m.resize((m + 2) * lanes);
+  products->e.resize((m + 2) * lanes);
+  products->zeros.resize((m + 2) * lanes);
+  for (int b = 0; b < lanes; ++b) {
+    products->m[lanes + b] = 0.5;
+    products->e[lanes + b] = 1;
+    products->zeros[lanes + b] = 0;
   }
+  for (elem_t v = 1; v <= m; ++v) {
+    for (int b = 0; b < lanes; ++b) {
+      const int j = v * lanes + b;
+      const double q = 1 - ps[j];
+      const double x = products->m[j] * (q > 0 ? q : 1);
+      int d = 0;
+      products->m[j + lanes] = std::frexp(x, &d);
+      products->e[j + lanes] = products->e[j] + d;
+      products->zeros[j + lanes] = products->zeros[j] + (q > 0 ? 0 : 1);
+    }
+  }
+}
+
+// This function returns the product of 1 - p over the elements from the
+// one of j to the one of k - 1, where j and k are indices of the products.
+static inline double skip_probability(const SkipProducts& products, int j,
+                                      int k) {
+  if (products.zeros[k] != products.zeros[j]) return 0;
+  return std::ldexp(products.m[k] / products.m[j],
+                    products.e[k] - products.e[j]);
 }
 
-// Algorithm C modified for ZDD, from Knuth vol. 4 fascicle 1 sec. 7.1.4 (p.75).
-double algo_c(zdd_t f) {
-  static map<word_t, double> counts;
-  if (is_term(f))
-    return f == top() ? 1 : 0;
-  else if (counts.find(id(f)) != counts.end())
-    return counts.at(id(f));
-  else
-    return counts[id(f)] = algo_c(hi(f)) + algo_c(lo(f));
+// The probabilities of the nodes are found bottom-up for all the lanes at
+// once, where those of each node are over elem() and the following
+// elements and are laid out node by node.  Each arc costs O(1) for a lane
+// with the products above.
+static void probability(const zdd_nodes& n, const vector<double>& ps,
+                        int lanes, double* results) {
+  const int t = num_elems() + 1;  // the element of the terminals
+  SkipProducts products;
+  skip_products(ps, lanes, &products);
+  vector<double> qs(n.size() * lanes, 0);
+  for (int b = 0; b < lanes; ++b) qs[lanes + b] = 1;
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    const elem_t v = n.elem(i);
+    zdd_nodes::index_t c[2] = {n.lo(i), n.hi(i)};
+    double* q = &qs[i * lanes];
+    for (int k = 0; k < 2; ++k) {
+      if (c[k] == 0) continue;
+      const int u = n.is_term(c[k]) ? t : n.elem(c[k]);
+      const double* qc = &qs[c[k] * lanes];
+      for (int b = 0; b < lanes; ++b) {
+        const double p = ps[v * lanes + b];
+        q[b] += (k == 0 ? 1 - p : p) *
+                skip_probability(products, (v + 1) * lanes + b,
+                                 u * lanes + b) *
+                qc[b];
+      }
+    }
+  }
+  const int u = n.is_term(n.root()) ? t : n.elem(n.root());
+  for (int b = 0; b < lanes; ++b) {
+    results[b] = skip_probability(products, lanes + b, u * lanes + b) *
+                 qs[n.root() * lanes + b];
+  }
 }
 
-static double skip_probability(elem_t e, zdd_t f,
-                               const vector<double>& probabilities) {
-  double p = 1;
-  for (int i = e; i < (is_term(f) ? num_elems() + 1 : elem(f)); ++i)
-    p *= 1 - probabilities[i];
+double probability(zdd_t f, const vector<double>& probabilities) {
+  zdd_nodes n(f);
+  double p;
+  probability(n, probabilities, 1, &p);
   return p;
 }
 
-double probability(elem_t e, zdd_t f, const vector<double>& probabilities,
-                   map<word_t, double>& cache) {
-  zdd_t l = lo(f);
-  zdd_t h = hi(f);
-  if (cache.find(id(l)) == cache.end())
-    cache[id(l)] = probability(elem(l), l, probabilities, cache);
-  if (cache.find(id(h)) == cache.end())
-    cache[id(h)] = probability(elem(h), h, probabilities, cache);
-  double pl = (1 - probabilities[elem(f)]) *
-              skip_probability(elem(f) + 1, l, probabilities) * cache.at(id(l));
-  double ph = probabilities[elem(f)] *
-              skip_probability(elem(f) + 1, h, probabilities) * cache.at(id(h));
-  return skip_probability(e, f, probabilities) * (pl + ph);
+// The vectors are evaluated in blocks of PROBABILITY_LANES, which share the
+// nodes of f and run in parallel.
+static const int PROBABILITY_LANES = 16;
+
+void probabilities(zdd_t f, const vector<vector<double> >& probabilities,
+                   vector<double>* results) {
+  assert(results != NULL);
+  results->assign(probabilities.size(), 0);
+  if (probabilities.empty()) return;
+  zdd_nodes n(f);
+  const elem_t m = num_elems();
+  const intmax_t blocks =
+      (probabilities.size() + PROBABILITY_LANES - 1) / PROBABILITY_LANES;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(tdzdd::maxThreads()) \
+    if (blocks > 1)
+#endif
+  for (intmax_t k = 0; k < blocks; ++k) {
+    const size_t begin = k * PROBABILITY_LANES;
+    const int lanes = static_cast<int>(std::min(
+        probabilities.size() - begin, static_cast<size_t>(PROBABILITY_LANES)));
+    vector<double> ps((m + 1) * lanes);
+    for (int b = 0; b < lanes; ++b) {
+      assert(probabilities[begin + b].size() == static_cast<size_t>(m) + 1);
+      for (elem_t v = 1; v <= m; ++v)
+        ps[v * lanes + b] = probabilities[begin + b][v];
+    }
+    probability(n, ps, lanes, &(*results)[begin]);
+  }
 }
 
 // Algorithm ZUNIQ from Knuth vol. 4 fascicle 1 sec. 7.1.4.
@@ -587,28 +686,294 @@ zdd_t zuniq(elem_t v, zdd_t l, zdd_t h) { return l + single(v) * h; }
 
 // G. Marsaglia, "Xorshift RNGs," Journal of Statistical Software, vol.8,
 // issue.14, 2003.  http://www.jstatsoft.org/v08/i14/
-double rand_xor128() {
-  static unsigned long x = 123456789, y = 362436069, z = 521288629,
-                       w = 88675123;
-  unsigned long t;
-  t = (x ^ (x << 11));
-  x = y;
-  y = z;
-  z = w;
-  w = (w ^ (w >> 19)) ^ (t ^ (t >> 8));
-  return static_cast<double>(w) / ULONG_MAX;
-}
-
-void sort_zdd(zdd_t f, vector<vector<zdd_t> >* stacks, set<word_t>* visited,
-              elem_t* max_elem) {
-  assert(stacks != NULL && visited != NULL);
-  if (is_term(f)) return;
-  if (visited->find(id(f)) != visited->end()) return;
-  (*stacks)[elem(f)].push_back(f);
-  visited->insert(id(f));
-  if (max_elem != NULL && elem(f) > *max_elem) *max_elem = elem(f);
-  sort_zdd(lo(f), stacks, visited, max_elem);
-  sort_zdd(hi(f), stacks, visited, max_elem);
+// This function returns 64 random bits made of two 32-bit outputs.
+uint64_t rand_xor128() {
+  static uint32_t x = 123456789, y = 362436069, z = 521288629, w = 88675123;
+  uint64_t r = 0;
+  for (int i = 0; i < 2; ++i) {
+    uint32_t t = x ^ (x << 11);
+    x = y;
+    y = z;
+    z = w;
+    w = (w ^ (w >> 19)) ^ (t ^ (t >> 8));
+    r = (r << 32) | w;
+  }
+  return r;
+}
+
+// This function returns an integer in [0, n) uniformly at random, where
+// the values below 2^64 mod n are rejected to avoid bias.
+static uint64_t rand_below(uint64_t n) {
+  assert(n > 0);
+  const uint64_t t = (0 - n) % n;
+  uint64_t r;
+  do {
+    r = rand_xor128();
+  } while (r < t);
+  return r % n;
+}
+
+zdd_nodes::zdd_nodes(zdd_t f) : f_(f) {
+  // collects the nodes by the depth-first search with an explicit stack,
+  // where the children are borrowed from f_ without reference counting
+  vector<word_t> ids;
+  vector<elem_t> elems;
+  vector<index_t> counts;
+  vector<word_t> stack(1, f.GetID());
+  while (!stack.empty()) {
+    word_t k = stack.back();
+    stack.pop_back();
+    if (k == bddfalse || k == bddtrue) continue;
+    if (indices_.find(k) != NULL) continue;
+    assert(ids.size() < UINT32_MAX - 2);
+    indices_.insert(k, static_cast<index_t>(ids.size()));
+    elem_t v = static_cast<elem_t>(bddtop(k));
+    ids.push_back(k);
+    elems.push_back(v);
+    if (counts.size() <= static_cast<size_t>(v)) counts.resize(v + 1, 0);
+    ++counts[v];
+    stack.push_back(bddgetzchild(k, 1));
+    stack.push_back(bddgetzchild(k, 0));
+  }
+
+  // sorts the nodes by their elements in the descending order
+  begins_.assign(counts.empty() ? 1 : counts.size(), 0);
+  index_t b = 2;
+  for (elem_t v = static_cast<elem_t>(begins_.size()) - 1; v > 0; --v) {
+    begins_[v] = b;
+    b += counts[v];
+  }
+  vector<index_t> next(begins_);
+  ids_.resize(ids.size() + 2);
+  elems_.resize(ids.size() + 2);
+  ids_[0] = bddfalse, ids_[1] = bddtrue;
+  elems_[0] = elems_[1] = 0;
+  for (size_t j = 0; j < ids.size(); ++j) {
+    index_t i = next[elems[j]]++;
+    *indices_.find(ids[j]) = i;
+    ids_[i] = ids[j];
+    elems_[i] = elems[j];
+  }
+
+  los_.resize(ids_.size(), 0);
+  his_.resize(ids_.size(), 0);
+  for (index_t i = 2; i < size(); ++i) {
+    los_[i] = index(bddgetzchild(ids_[i], 0));
+    his_[i] = index(bddgetzchild(ids_[i], 1));
+  }
+  root_ = index(f.GetID());
+}
+
+zdd_nodes::index_t zdd_nodes::index(word_t k) const {
+  if (k == bddfalse) return 0;
+  if (k == bddtrue) return 1;
+  const index_t* i = indices_.find(k);
+  assert(i != NULL);
+  return *i;
+}
+
+zdd_sampler::zdd_sampler(zdd_t f) : nodes_(bot()) { this->build(f); }
+
+// A number m * 2^e with 0.5 <= m < 1 unless it is zero.
+struct ScaledCount {
+  double m;
+  int e;
+};
+
+static ScaledCount add_scaled(const ScaledCount& a, const ScaledCount& b) {
+  if (a.m == 0) return b;
+  if (b.m == 0) return a;
+  const ScaledCount& x = a.e >= b.e ? a : b;
+  const ScaledCount& y = a.e >= b.e ? b : a;
+  ScaledCount c;
+  int d;
+  c.m = std::frexp(x.m + std::ldexp(y.m, y.e - x.e), &d);
+  c.e = x.e + d;
+  return c;
+}
+
+void zdd_sampler::build(zdd_t f) {
+  this->f_ = f;
+  this->nodes_ = zdd_nodes(f);
+  this->drawn_.clear();
+  const zdd_nodes& n = this->nodes_;
+  this->counts_.assign(n.size(), 0);
+  this->counts_[1] = 1;
+  this->exact_ = true;
+  for (zdd_nodes::index_t i = 2; i < n.size() && this->exact_; ++i) {
+    this->counts_[i] = this->counts_[n.lo(i)] + this->counts_[n.hi(i)];
+    this->exact_ = this->counts_[i] >= this->counts_[n.hi(i)];  // overflow
+  }
+  this->ratios_.clear();
+  if (this->exact_) {
+    this->size_ = static_cast<double>(this->counts_[n.root()]);
+    return;
+  }
+  this->counts_.clear();
+  vector<ScaledCount> cs(n.size());
+  cs[0].m = 0, cs[0].e = 0;
+  cs[1].m = 0.5, cs[1].e = 1;
+  this->ratios_.assign(n.size(), 0);
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    const ScaledCount& h = cs[n.hi(i)];
+    cs[i] = add_scaled(cs[n.lo(i)], h);
+    this->ratios_[i] = std::ldexp(h.m, h.e - cs[i].e) / cs[i].m;
+  }
+  this->size_ = std::ldexp(cs[n.root()].m, cs[n.root()].e);
+}
+
+void zdd_sampler::descend(vector<elem_t>* s) const {
+  const zdd_nodes& n = this->nodes_;
+  zdd_nodes::index_t i = n.root();
+  if (this->exact_) {
+    uint64_t r = rand_below(this->counts_[i]);
+    while (!n.is_term(i)) {
+      const uint64_t c = this->counts_[n.hi(i)];
+      if (r < c) {
+        s->push_back(n.elem(i));
+        i = n.hi(i);
+      } else {
+        r -= c;
+        i = n.lo(i);
+      }
+    }
+  } else {
+    while (!n.is_term(i)) {
+      double u = std::ldexp(static_cast<double>(rand_xor128() >> 11), -53);
+      if (u < this->ratios_[i]) {
+        s->push_back(n.elem(i));
+        i = n.hi(i);
+      } else {
+        i = n.lo(i);
+      }
+    }
+  }
+  assert(i == 1);
+}
+
+bool zdd_sampler::draw(bool replace, vector<elem_t>* s) {
+  assert(s != NULL);
+  if (this->f_ == bot()) return false;
+  do {
+    s->clear();
+    this->descend(s);
+  } while (!replace && !this->drawn_.insert(*s).second);
+  if (this->exact_ &&
+      this->drawn_.size() * 2 >= this->counts_[this->nodes_.root()]) {
+    zdd_t g = bot();
+    for (set<vector<elem_t> >::const_iterator i = this->drawn_.begin();
+         i != this->drawn_.end(); ++i) {
+      zdd_t h = top();
+      for (vector<elem_t>::const_reverse_iterator e = i->rbegin();
+           e != i->rend(); ++e)
+        h = ZBDD_Node(*e, bot(), h);
+      g += h;
+    }
+    this->build(this->f_ - g);
+  }
+  return true;
+}
+
+// The potentials are the maximum weights from the nodes to top() as
+// Algorithm B modified for ZDD, from Knuth vol. 4 fascicle 1 sec. 7.1.4,
+// where lo() is preferred for a tie.
+zdd_kbest::zdd_kbest(zdd_t f, const vector<double>& weights)
+    : nodes_(f), weights_(weights) {
+  const zdd_nodes& n = this->nodes_;
+  assert(weights.size() > static_cast<size_t>(n.max_elem()));
+  this->potentials_.resize(n.size());
+  this->best_.assign(n.size(), false);
+  this->potentials_[0] = -std::numeric_limits<double>::infinity();
+  this->potentials_[1] = 0;
+  for (zdd_nodes::index_t i = 2; i < n.size(); ++i) {
+    zdd_nodes::index_t l = n.lo(i);
+    double m = this->potentials_[n.hi(i)] + weights[n.elem(i)];
+    this->potentials_[i] = this->potentials_[l];
+    if (l == 0 || m > this->potentials_[i]) {
+      this->potentials_[i] = m;
+      this->best_[i] = true;
+    }
+  }
+  if (f != bot()) {
+    Candidate c = {this->potentials_[n.root()], NO_PATH, 0};
+    this->heap_.push_back(c);
+  }
+}
+
+bool zdd_kbest::next(vector<elem_t>* s) {
+  assert(s != NULL);
+  if (this->heap_.empty()) return false;
+  std::pop_heap(this->heap_.begin(), this->heap_.end(), Worse(*this));
+  const Candidate c = this->heap_.back();
+  this->heap_.pop_back();
+  const zdd_nodes& n = this->nodes_;
+
+  // copies the prefix of the parent path and takes the other branch
+  const size_t path = this->begins_.size();
+  const size_t begin = this->path_nodes_.size();
+  this->begins_.push_back(begin);
+  zdd_nodes::index_t i = n.root();
+  if (c.path != NO_PATH) {
+    const size_t b = this->begins_[c.path];
+    for (size_t p = b; p <= b + c.pos; ++p) {
+      this->path_nodes_.push_back(this->path_nodes_[p]);
+      this->branches_.push_back(this->branches_[p]);
+    }
+    this->branches_.back() = !this->branches_.back();
+    i = this->path_nodes_.back();
+    i = this->branches_.back() ? n.hi(i) : n.lo(i);
+  }
+  // follows the best branches to top()
+  for (; !n.is_term(i); i = this->best_[i] ? n.hi(i) : n.lo(i)) {
+    this->path_nodes_.push_back(i);
+    this->branches_.push_back(this->best_[i]);
+  }
+  assert(i == 1);
+
+  // adds the deviations after the branch taken above
+  s->clear();
+  double w = 0;
+  const size_t first = c.path != NO_PATH ? begin + c.pos + 1 : begin;
+  for (size_t p = begin; p < this->path_nodes_.size(); ++p) {
+    zdd_nodes::index_t j = this->path_nodes_[p];
+    double x = this->weights_[n.elem(j)];
+    if (p >= first) {
+      zdd_nodes::index_t k = this->branches_[p] ? n.lo(j) : n.hi(j);
+      if (k != 0) {
+        double v = w + (this->branches_[p] ? 0 : x) + this->potentials_[k];
+        Candidate d = {v, path, static_cast<uint32_t>(p - begin)};
+        this->heap_.push_back(d);
+        std::push_heap(this->heap_.begin(), this->heap_.end(), Worse(*this));
+      }
+    }
+    if (this->branches_[p]) {
+      w += x;
+      s->push_back(n.elem(j));
+    }
+  }
+  return true;
+}
+
+// This function returns the j-th branch of the path given by c, where i is
+// the j-th node.
+bool zdd_kbest::branch(const Candidate& c, size_t j,
+                       zdd_nodes::index_t i) const {
+  if (c.path == NO_PATH || j > c.pos) return this->best_[i];
+  bool b = this->branches_[this->begins_[c.path] + j];
+  return j < c.pos ? b : !b;
+}
+
+// This function returns true if the path given by a takes lo() at the
+// first branch different from the path given by b.
+bool zdd_kbest::precedes(const Candidate& a, const Candidate& b) const {
+  const zdd_nodes& n = this->nodes_;
+  zdd_nodes::index_t i = n.root();
+  for (size_t j = 0; !n.is_term(i); ++j) {
+    bool x = this->branch(a, j, i);
+    if (x != this->branch(b, j, i)) return !x;
+    i = x ? n.hi(i) : n.lo(i);
+  }
+  return false;
 }
 
 }  // namespace digraphillion
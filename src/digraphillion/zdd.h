@@ -24,8 +24,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <assert.h>
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "digraphillion/type.h"
 
@@ -59,6 +61,7 @@ inline elem_t elem(zdd_t f) {
 
 zdd_t operator|(const zdd_t& f, const zdd_t& g);
 
+zdd_t universe();
 zdd_t complement(zdd_t f);
 zdd_t minimal(zdd_t f);
 zdd_t maximal(zdd_t f);
@@ -67,10 +70,6 @@ zdd_t join(zdd_t f, zdd_t g);
 zdd_t meet(zdd_t f, zdd_t g);
 zdd_t non_subsets(zdd_t f, zdd_t g);
 zdd_t non_supersets(zdd_t f, zdd_t g);
-bool choose(zdd_t f, std::vector<elem_t>* stack);
-zdd_t choose_random(zdd_t f, std::vector<elem_t>* stack);
-zdd_t choose_best(zdd_t f, const std::vector<double>& weights,
-                  std::set<elem_t>* s);
 void dump(zdd_t f, std::ostream& out);
 void dump(zdd_t f, FILE* fp = stdout);
 zdd_t load(std::istream& in);
@@ -85,18 +84,255 @@ void _enum(zdd_t f, std::ostream& out, std::vector<elem_t>* stack, bool* first,
            const std::pair<const char*, const char*>& inner_braces);
 void _enum(zdd_t f, FILE* fp, std::vector<elem_t>* stack, bool* first,
            const std::pair<const char*, const char*>& inner_braces);
-void algo_b(zdd_t f, const std::vector<double>& w, std::vector<bool>* x);
-double algo_c(zdd_t f);
-double probability(elem_t e, zdd_t f, const std::vector<double>& probabilities,
-                   std::map<word_t, double>& cache);
+std::string count(zdd_t f);
+zdd_t size_window(zdd_t f, int lower, int upper);
+void size_histogram(zdd_t f, std::vector<std::string>* counts);
+double probability(zdd_t f, const std::vector<double>& probabilities);
+void probabilities(zdd_t f,
+                   const std::vector<std::vector<double> >& probabilities,
+                   std::vector<double>* results);
 zdd_t zuniq(elem_t v, zdd_t l, zdd_t h);
-double rand_xor128();
-void sort_zdd(zdd_t f, std::vector<std::vector<zdd_t> >* stacks,
-              std::set<word_t>* visited, elem_t* max_elem = NULL);
+uint64_t rand_xor128();
 inline std::pair<word_t, word_t> make_key(zdd_t f, zdd_t g) {
   return std::make_pair(id(f), id(g));
 }
 
+// An open-addressing hash map from the ids of ZBDD nodes to values, which
+// is much faster than std::map for millions of nodes.  The nodes made
+// together are usually close in the node table, so the ids are kept in
+// order in the table unless the probes get long, which happens when the ids
+// are spread over a range much larger than the table; then the ids are
+// scattered by a multiplicative hash until the table grows.
+template <typename T>
+class zdd_node_map {
+ public:
+  zdd_node_map()
+      : keys_(16, bddnull), values_(16), size_(0), scattered_(false),
+        probes_(0) {}
+
+  size_t size() const { return size_; }
+
+  // This function makes room for n entries.
+  void reserve(size_t n) {
+    size_t size = keys_.size();
+    while (size < n * 2) size *= 2;
+    if (size > keys_.size()) rehash(size / keys_.size());
+  }
+
+  // This function returns the value of k, or NULL if not found.
+  const T* find(word_t k) const {
+    size_t h = slot(k);
+    return keys_[h] == k ? &values_[h] : NULL;
+  }
+  T* find(word_t k) {
+    size_t h = slot(k);
+    return keys_[h] == k ? &values_[h] : NULL;
+  }
+
+  // This function adds k, which must not be in the map.
+  void insert(word_t k, const T& v) {
+    assert(k != bddnull);
+    if ((size_ + 1) * 2 > keys_.size()) rehash(2);
+    size_t h = slot(k);
+    assert(keys_[h] != k);
+    keys_[h] = k;
+    values_[h] = v;
+    ++size_;
+    probes_ += (h - home(k)) & (keys_.size() - 1);
+    if (!scattered_ && probes_ > 8 * size_) {
+      scattered_ = true;
+      rehash(1);
+    }
+  }
+
+  void swap(zdd_node_map& o) {
+    keys_.swap(o.keys_);
+    values_.swap(o.values_);
+    std::swap(size_, o.size_);
+    std::swap(scattered_, o.scattered_);
+    std::swap(probes_, o.probes_);
+  }
+
+ private:
+  std::vector<word_t> keys_;
+  std::vector<T> values_;
+  size_t size_;
+  bool scattered_;  // whether the ids are hashed out of order
+  size_t probes_;   // the total length of the probes for the entries
+
+  // This function returns the slot where the search for k starts.
+  size_t home(word_t k) const {
+    if (!scattered_) return static_cast<size_t>(k >> 1) & (keys_.size() - 1);
+    const uint64_t x = static_cast<uint64_t>(k) * 0x9E3779B97F4A7C15ULL;
+    return (x ^ (x >> 32)) & (keys_.size() - 1);
+  }
+
+  // This function returns the slot of k, or the empty slot where k is to
+  // be inserted.
+  size_t slot(word_t k) const {
+    const size_t mask = keys_.size() - 1;
+    size_t h = home(k);
+    while (keys_[h] != k && keys_[h] != bddnull) h = (h + 1) & mask;
+    return h;
+  }
+
+  // This function rebuilds the table with the size multiplied by factor,
+  // where a larger table tries to keep the ids in order again.
+  void rehash(size_t factor) {
+    std::vector<word_t> keys(keys_.size() * factor, bddnull);
+    std::vector<T> values(keys.size());
+    keys.swap(keys_);
+    values.swap(values_);
+    if (factor > 1) scattered_ = false;
+    for (;;) {
+      probes_ = 0;
+      for (size_t h = 0; h < keys.size(); ++h) {
+        if (keys[h] == bddnull) continue;
+        size_t j = slot(keys[h]);
+        keys_[j] = keys[h];
+        values_[j] = values[h];
+        probes_ += (j - home(keys[h])) & (keys_.size() - 1);
+      }
+      if (scattered_ || probes_ <= 8 * size_) break;
+      scattered_ = true;
+      std::fill(keys_.begin(), keys_.end(), bddnull);
+    }
+  }
+};
+
+// The nodes of a ZDD collected without recursion and numbered densely in
+// the bottom-up order.  bot() and top() are numbered 0 and 1, and the
+// other nodes follow from the largest element to the smallest, so the
+// children of a node are always numbered before it.  The nodes of each
+// element are contiguous in the order they are found by the depth-first
+// search that visits lo() before hi().  Bottom-up evaluations run over
+// 0, ..., size() - 1 with plain vectors indexed by the numbers, and
+// top-down ones in the reverse order.
+class zdd_nodes {
+ public:
+  typedef uint32_t index_t;
+
+  explicit zdd_nodes(zdd_t f);
+
+  // the number of the nodes including the two terminals
+  index_t size() const { return static_cast<index_t>(ids_.size()); }
+  index_t root() const { return root_; }
+  // the largest element in the ZDD, or 0 if it is a terminal
+  elem_t max_elem() const { return static_cast<elem_t>(begins_.size()) - 1; }
+
+  // the nodes of element v are begin(v), ..., end(v) - 1
+  index_t begin(elem_t v) const { return begins_[v]; }
+  index_t end(elem_t v) const { return v > 1 ? begins_[v - 1] : size(); }
+
+  word_t id(index_t i) const { return ids_[i]; }
+  // the element of node i, or 0 for the terminals
+  elem_t elem(index_t i) const { return elems_[i]; }
+  index_t lo(index_t i) const { return los_[i]; }
+  index_t hi(index_t i) const { return his_[i]; }
+  bool is_term(index_t i) const { return i < 2; }
+
+  // This function returns the number of the node of id k, which must be
+  // in the ZDD.
+  index_t index(word_t k) const;
+
+ private:
+  zdd_t f_;  // holds the nodes while they are referred by ids_
+  index_t root_;
+  std::vector<word_t> ids_;
+  std::vector<elem_t> elems_;
+  std::vector<index_t> los_;
+  std::vector<index_t> his_;
+  std::vector<index_t> begins_;
+  zdd_node_map<index_t> indices_;  // from the ids to the numbers
+};
+
+// A sampler that draws the sets in a ZDD uniformly at random in O(depth)
+// each.  The numbers of the sets under the nodes are kept as exact 64-bit
+// integers if the ZDD has less than 2^64 sets.  Otherwise only the
+// probabilities of taking hi() are kept, which are computed with separate
+// exponents so as not to overflow.  Without replacement, the drawn sets
+// are rejected until a half of the sets are drawn, and then they are
+// removed from the ZDD and the numbers are computed again.
+class zdd_sampler {
+ public:
+  explicit zdd_sampler(zdd_t f = bot());
+
+  // the number of the sets in the ZDD, which may be inexact beyond 2^53;
+  // the drawn sets are not subtracted until the ZDD is rebuilt
+  double size() const { return size_; }
+
+  // This function draws a set into s in the ascending order and returns
+  // true, or returns false if no set is left.
+  bool draw(bool replace, std::vector<elem_t>* s);
+
+ private:
+  zdd_t f_;
+  zdd_nodes nodes_;
+  bool exact_;
+  double size_;
+  std::vector<uint64_t> counts_;
+  std::vector<double> ratios_;
+  std::set<std::vector<elem_t> > drawn_;
+
+  void build(zdd_t f);
+  void descend(std::vector<elem_t>* s) const;
+};
+
+// An enumerator of the sets in a ZDD in the descending order of the sums
+// of the weights, which are indexed by the elements.  The sets are the
+// paths to top(), and the maximum weights from the nodes to top() are
+// computed once.  Each path is given by a deviation from an enumerated
+// path, i.e., the other branch at one of its nodes followed by the best
+// branches, and the deviations are kept in a heap.  A path adds the
+// deviations only after the branch it has taken from its parent, so every
+// path is enumerated exactly once.  Ties are broken by preferring lo() at
+// the first different branch.
+class zdd_kbest {
+ public:
+  zdd_kbest(zdd_t f, const std::vector<double>& weights);
+
+  // This function writes the next best set to s in the ascending order
+  // and returns true, or returns false if all the sets are enumerated.
+  bool next(std::vector<elem_t>* s);
+
+ private:
+  static const size_t NO_PATH = static_cast<size_t>(-1);
+
+  // the path taking the other branch at the pos-th node of the path,
+  // whose total weight is value; the best path is given by NO_PATH
+  struct Candidate {
+    double value;
+    size_t path;
+    uint32_t pos;
+  };
+
+  // the order of the heap, in which the next best path is the greatest
+  class Worse {
+   public:
+    explicit Worse(const zdd_kbest& k) : k_(k) {}
+    bool operator()(const Candidate& a, const Candidate& b) const {
+      return a.value != b.value ? a.value < b.value : k_.precedes(b, a);
+    }
+
+   private:
+    const zdd_kbest& k_;
+  };
+
+  bool branch(const Candidate& c, size_t j, zdd_nodes::index_t i) const;
+  bool precedes(const Candidate& a, const Candidate& b) const;
+
+  zdd_nodes nodes_;
+  std::vector<double> weights_;
+  std::vector<double> potentials_;
+  std::vector<bool> best_;  // true if hi() is the best branch
+  std::vector<Candidate> heap_;
+  // the nodes and the branches of the k-th enumerated path are
+  // path_nodes_[begins_[k]], ... and branches_[begins_[k]], ...
+  std::vector<size_t> begins_;
+  std::vector<zdd_nodes::index_t> path_nodes_;
+  std::vector<bool> branches_;
+};
+
 }  // namespace digraphillion
 
 #endif  // DIGRAPHILLION_ZDD_H_
@@ -25,12 +25,15 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <assert.h>
 
 #include <algorithm>
+#include <climits>
 #include <map>
+#include <new>
 #include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "digraphillion/edge_order.h"
 #include "digraphillion/graphset.h"
 #include "py3c.h"
 #include "py3c/tpflags.h"
@@ -238,7 +241,33 @@ static PyObject* setsetiter_next(PySetsetIterObject* self) {
   return setset_build_set(s);
 }
 
+static PyObject* setsetiter_next_n(PySetsetIterObject* self, PyObject* obj) {
+  if (!PyInt_Check(obj)) {
+    PyErr_SetString(PyExc_TypeError, "not int");
+    return NULL;
+  }
+  long k = PyLong_AsLong(obj);
+  if (k < 0) {
+    PyErr_SetString(PyExc_ValueError, "negative count");
+    return NULL;
+  }
+  std::vector<std::set<int> > v;
+  self->it->next_n(k, &v);
+  PyObject* lo = PyList_New(v.size());
+  if (lo == NULL) return NULL;
+  for (size_t i = 0; i < v.size(); ++i) {
+    PyObject* so = setset_build_set(v[i]);
+    if (so == NULL) {
+      Py_DECREF(lo);
+      return NULL;
+    }
+    PyList_SET_ITEM(lo, i, so);
+  }
+  return lo;
+}
+
 static PyMethodDef setsetiter_methods[] = {
+    {"next_n", reinterpret_cast<PyCFunction>(setsetiter_next_n), METH_O, ""},
     {NULL, NULL} /* sentinel */
 };
 
@@ -530,6 +559,29 @@ static PyObject* setset_rand_iter(PySetsetObject* self) {
   return reinterpret_cast<PyObject*>(ssi);
 }
 
+static PyObject* setset_sample(PySetsetObject* self, PyObject* args) {
+  Py_ssize_t n;
+  int replace = true;
+  if (!PyArg_ParseTuple(args, "n|p", &n, &replace)) return NULL;
+  if (n < 0) {
+    PyErr_SetString(PyExc_ValueError, "negative sample size");
+    return NULL;
+  }
+  std::vector<std::set<int> > v;
+  self->ss->sample(n, replace, &v);
+  PyObject* lo = PyList_New(v.size());
+  if (lo == NULL) return NULL;
+  for (size_t i = 0; i < v.size(); ++i) {
+    PyObject* so = setset_build_set(v[i]);
+    if (so == NULL) {
+      Py_DECREF(lo);
+      return NULL;
+    }
+    PyList_SET_ITEM(lo, i, so);
+  }
+  return lo;
+}
+
 static PyObject* setset_optimize(PySetsetObject* self, PyObject* weights,
                                  bool is_maximizing) {
   PyObject* i = PyObject_GetIter(weights);
@@ -714,6 +766,22 @@ static PyObject* setset_set_size(PySetsetObject* self, PyObject* io) {
   RETURN_NEW_SETSET(self, self->ss->set_size(set_size));
 }
 
+static PyObject* setset_size_histogram(PySetsetObject* self) {
+  std::vector<std::string> counts = self->ss->size_histogram();
+  PyObject* lo = PyList_New(counts.size());
+  if (lo == NULL) return NULL;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    PyObject* co =
+        PyLong_FromString(const_cast<char*>(counts[i].c_str()), NULL, 0);
+    if (co == NULL) {
+      Py_DECREF(lo);
+      return NULL;
+    }
+    PyList_SET_ITEM(lo, i, co);
+  }
+  return lo;
+}
+
 static PyObject* setset_join(PySetsetObject* self, PyObject* other) {
   CHECK_SETSET_OR_ERROR(other);
   RETURN_NEW_SETSET2(self, other, _other, self->ss->join(*_other->ss));
@@ -768,30 +836,67 @@ static PyObject* setset_choice(PySetsetObject* self) {
   return setset_build_set(s);
 }
 
-static PyObject* setset_probability(PySetsetObject* self,
-                                    PyObject* probabilities) {
+static bool setset_parse_probabilities(PyObject* probabilities,
+                                       std::vector<double>* p) {
   PyObject* i = PyObject_GetIter(probabilities);
-  if (i == NULL) return NULL;
+  if (i == NULL) return false;
   PyObject* eo;
-  std::vector<double> p;
   while ((eo = PyIter_Next(i))) {
     if (PyFloat_Check(eo)) {
-      p.push_back(PyFloat_AsDouble(eo));
+      p->push_back(PyFloat_AsDouble(eo));
     } else if (PyLong_Check(eo)) {
-      p.push_back(static_cast<double>(PyLong_AsLong(eo)));
+      p->push_back(static_cast<double>(PyLong_AsLong(eo)));
     } else if (PyInt_Check(eo)) {
-      p.push_back(static_cast<double>(PyInt_AsLong(eo)));
+      p->push_back(static_cast<double>(PyInt_AsLong(eo)));
     } else {
       PyErr_SetString(PyExc_TypeError, "not a number");
       Py_DECREF(eo);
-      return NULL;
+      Py_DECREF(i);
+      return false;
     }
     Py_DECREF(eo);
   }
   Py_DECREF(i);
+  return true;
+}
+
+static PyObject* setset_probability(PySetsetObject* self,
+                                    PyObject* probabilities) {
+  std::vector<double> p;
+  if (!setset_parse_probabilities(probabilities, &p)) return NULL;
   return PyFloat_FromDouble(self->ss->probability(p));
 }
 
+static PyObject* setset_probabilities(PySetsetObject* self,
+                                      PyObject* probabilities) {
+  PyObject* i = PyObject_GetIter(probabilities);
+  if (i == NULL) return NULL;
+  const size_t n = digraphillion::setset::num_elems() + 1;
+  PyObject* po;
+  std::vector<std::vector<double> > ps;
+  while ((po = PyIter_Next(i))) {
+    ps.push_back(std::vector<double>());
+    bool ok = setset_parse_probabilities(po, &ps.back());
+    Py_DECREF(po);
+    if (!ok) {
+      Py_DECREF(i);
+      return NULL;
+    }
+    if (ps.back().size() != n) {
+      PyErr_SetString(PyExc_ValueError, "wrong number of probabilities");
+      Py_DECREF(i);
+      return NULL;
+    }
+  }
+  Py_DECREF(i);
+  std::vector<double> results = self->ss->probabilities(ps);
+  PyObject* lo = PyList_New(results.size());
+  if (lo == NULL) return NULL;
+  for (size_t j = 0; j < results.size(); ++j)
+    PyList_SET_ITEM(lo, j, PyFloat_FromDouble(results[j]));
+  return lo;
+}
+
 static PyObject* setset_dump(PySetsetObject* self, PyObject* obj) {
   CHECK_OR_ERROR(obj, PyFile_Check, "file", NULL);
 #if IS_PY3 == 1
@@ -987,6 +1092,8 @@ static PyMethodDef setset_methods[] = {
     {"iter", reinterpret_cast<PyCFunction>(setset_iter), METH_NOARGS, ""},
     {"rand_iter", reinterpret_cast<PyCFunction>(setset_rand_iter), METH_NOARGS,
      ""},
+    {"sample", reinterpret_cast<PyCFunction>(setset_sample), METH_VARARGS,
+     ""},
     {"max_iter", reinterpret_cast<PyCFunction>(setset_max_iter), METH_O, ""},
     {"min_iter", reinterpret_cast<PyCFunction>(setset_min_iter), METH_O, ""},
     {"add", reinterpret_cast<PyCFunction>(setset_add), METH_O, ""},
@@ -1000,6 +1107,8 @@ static PyMethodDef setset_methods[] = {
     {"smaller", reinterpret_cast<PyCFunction>(setset_smaller), METH_O, ""},
     {"larger", reinterpret_cast<PyCFunction>(setset_larger), METH_O, ""},
     {"set_size", reinterpret_cast<PyCFunction>(setset_set_size), METH_O, ""},
+    {"size_histogram", reinterpret_cast<PyCFunction>(setset_size_histogram),
+     METH_NOARGS, ""},
     {"flip", reinterpret_cast<PyCFunction>(setset_flip), METH_VARARGS, ""},
     {"join", reinterpret_cast<PyCFunction>(setset_join), METH_O, ""},
     {"meet", reinterpret_cast<PyCFunction>(setset_meet), METH_O, ""},
@@ -1012,6 +1121,8 @@ static PyMethodDef setset_methods[] = {
     {"choice", reinterpret_cast<PyCFunction>(setset_choice), METH_NOARGS, ""},
     {"probability", reinterpret_cast<PyCFunction>(setset_probability), METH_O,
      ""},
+    {"probabilities", reinterpret_cast<PyCFunction>(setset_probabilities),
+     METH_O, ""},
     {"dump", reinterpret_cast<PyCFunction>(setset_dump), METH_O, ""},
     {"dumps", reinterpret_cast<PyCFunction>(setset_dumps), METH_NOARGS, ""},
     {"_enum", reinterpret_cast<PyCFunction>(setset_enum), METH_O, ""},
@@ -1201,6 +1312,47 @@ bool input_graph(PyObject* graph_obj,
   return true;
 }
 
+// This class holds the handle of the digraph given to a search.  If the
+// digraph is given by a list of edges, it is registered as a temporary
+// graph, which is released at the end of the search, so the handle of
+// the universe graph stays valid.
+class GraphHandle {
+ public:
+  GraphHandle() : handle_(0), temporary_(false) {}
+  ~GraphHandle() {
+    if (temporary_) digraphillion::ReleaseTemporaryGraph(handle_);
+  }
+
+  // graph_obj is either a handle returned by _register_universe_graph or
+  // a list of edges.
+  bool input(PyObject* graph_obj) {
+    if (graph_obj != NULL && PyInt_Check(graph_obj)) {
+      handle_ = PyInt_AsLong(graph_obj);
+      if (!digraphillion::IsRegisteredUniverseGraph(handle_)) {
+        PyErr_SetString(PyExc_ValueError, "invalid graph handle");
+        return false;
+      }
+      return true;
+    }
+    std::vector<std::pair<std::string, std::string> > graph;
+    if (!input_graph(graph_obj, graph)) {
+      return false;
+    }
+    handle_ = digraphillion::RegisterTemporaryGraph(graph);
+    temporary_ = true;
+    return true;
+  }
+
+  int get() const { return handle_; }
+
+ private:
+  int handle_;
+  bool temporary_;
+
+  GraphHandle(const GraphHandle&);
+  GraphHandle& operator=(const GraphHandle&);
+};
+
 bool input_string_list(PyObject* list_obj, std::vector<std::string>& list) {
   if (list_obj == NULL || list_obj == Py_None) {
     PyErr_SetString(PyExc_TypeError, "no input");
@@ -1253,19 +1405,68 @@ bool input_vertex_to_range_map(
   return true;
 }
 
+// estimate_obj is None or the width limit of the sampled build run by the
+// Estimate* functions instead of the search.  *width_limit is set to 0 in
+// the former case.
+bool input_width_limit(PyObject* estimate_obj, int* width_limit) {
+  *width_limit = 0;
+  if (estimate_obj == NULL || estimate_obj == Py_None) return true;
+  CHECK_OR_ERROR(estimate_obj, PyInt_Check, "int", false);
+  *width_limit = PyInt_AsLong(estimate_obj);
+  if (*width_limit <= 0) {
+    PyErr_SetString(PyExc_ValueError, "width limit must be positive");
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+static PyObject* build_float_list(const std::vector<T>& v) {
+  PyObject* lo = PyList_New(v.size());
+  if (lo == NULL) return NULL;
+  for (size_t j = 0; j < v.size(); ++j) {
+    PyList_SET_ITEM(lo, j, PyFloat_FromDouble(v[j]));
+  }
+  return lo;
+}
+
+static PyObject* build_estimate(const digraphillion::SearchEstimate& e) {
+  PyObject* frontier_sizes = PyList_New(e.frontier_sizes.size());
+  if (frontier_sizes == NULL) return NULL;
+  for (size_t j = 0; j < e.frontier_sizes.size(); ++j) {
+    PyList_SET_ITEM(frontier_sizes, j, PyInt_FromLong(e.frontier_sizes[j]));
+  }
+  PyObject* state_bounds = build_float_list(e.state_bounds);
+  PyObject* node_counts = build_float_list(e.node_counts);
+  if (state_bounds == NULL || node_counts == NULL) {
+    Py_DECREF(frontier_sizes);
+    Py_XDECREF(state_bounds);
+    Py_XDECREF(node_counts);
+    return NULL;
+  }
+  return Py_BuildValue(
+      "{s:i,s:N,s:N,s:d,s:i,s:N,s:d,s:d,s:d,s:O}", "max_frontier_size",
+      e.max_frontier_size, "frontier_sizes", frontier_sizes, "state_bounds",
+      state_bounds, "state_bound", e.state_bound, "width_limit", e.width_limit,
+      "node_counts", node_counts, "nodes", e.nodes, "seconds", e.seconds,
+      "memory", e.memory, "exact", e.exact ? Py_True : Py_False);
+}
+
 static PyObject* graphset_directed_cycles(PyObject*, PyObject* args,
                                           PyObject* kwds) {
   static char s1[] = "graph";
   static char s2[] = "search_space";
-  static char* kwlist[3] = {s1, s2, NULL};
+  static char s3[] = "estimate";
+  static char* kwlist[4] = {s1, s2, s3, NULL};
   PyObject* graph_obj = NULL;
   PyObject* search_space_obj = NULL;
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", kwlist, &graph_obj,
-                                   &search_space_obj))
+  PyObject* estimate_obj = NULL;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO", kwlist, &graph_obj,
+                                   &search_space_obj, &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1273,8 +1474,19 @@ static PyObject* graphset_directed_cycles(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss =
-      digraphillion::SearchDirectedCycles(graph, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedCycles(
+        graph.get(), search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedCycles(graph.get(), search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1286,15 +1498,17 @@ static PyObject* graphset_directed_hamiltonian_cycles(PyObject*, PyObject* args,
                                                       PyObject* kwds) {
   static char s1[] = "graph";
   static char s2[] = "search_space";
-  static char* kwlist[3] = {s1, s2, NULL};
+  static char s3[] = "estimate";
+  static char* kwlist[4] = {s1, s2, s3, NULL};
   PyObject* graph_obj = NULL;
   PyObject* search_space_obj = NULL;
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", kwlist, &graph_obj,
-                                   &search_space_obj))
+  PyObject* estimate_obj = NULL;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OO", kwlist, &graph_obj,
+                                   &search_space_obj, &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1302,8 +1516,20 @@ static PyObject* graphset_directed_hamiltonian_cycles(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss =
-      digraphillion::SearchDirectedHamiltonianCycles(graph, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedHamiltonianCycles(
+        graph.get(), search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedHamiltonianCycles(graph.get(),
+                                                        search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1318,19 +1544,21 @@ static PyObject* graphset_directed_st_path(PyObject*, PyObject* args,
   static char s3[] = "t";
   static char s4[] = "is_hamiltonian";
   static char s5[] = "search_space";
-  static char* kwlist[] = {s1, s2, s3, s4, s5, NULL};
+  static char s6[] = "estimate";
+  static char* kwlist[] = {s1, s2, s3, s4, s5, s6, NULL};
   PyObject* graph_obj = NULL;
   int is_hamiltonian = false;
   PyObject* s_obj = NULL;
   PyObject* t_obj = NULL;
   PyObject* search_space_obj = NULL;
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OSSp|O", kwlist, &graph_obj,
+  PyObject* estimate_obj = NULL;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OSSp|OO", kwlist, &graph_obj,
                                    &s_obj, &t_obj, &is_hamiltonian,
-                                   &search_space_obj))
+                                   &search_space_obj, &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1359,8 +1587,20 @@ static PyObject* graphset_directed_st_path(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss = digraphillion::SearchDirectedSTPath(
-      graph, is_hamiltonian, s, t, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedSTPath(
+        graph.get(), is_hamiltonian, s, t, search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedSTPath(
+        graph.get(), is_hamiltonian, s, t, search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1374,17 +1614,20 @@ static PyObject* graphset_rooted_forests(PyObject*, PyObject* args,
   static char s2[] = "roots";
   static char s3[] = "is_spanning";
   static char s4[] = "search_space";
-  static char* kwlist[] = {s1, s2, s3, s4, NULL};
+  static char s5[] = "estimate";
+  static char* kwlist[] = {s1, s2, s3, s4, s5, NULL};
   PyObject* graph_obj = NULL;
   PyObject* roots_obj = NULL;
   PyObject* search_space_obj = NULL;
+  PyObject* estimate_obj = NULL;
   int is_spanning;
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OpO", kwlist, &graph_obj,
-                                   &roots_obj, &is_spanning, &search_space_obj))
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OpOO", kwlist, &graph_obj,
+                                   &roots_obj, &is_spanning, &search_space_obj,
+                                   &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1399,8 +1642,20 @@ static PyObject* graphset_rooted_forests(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss = digraphillion::SearchDirectedForests(
-      graph, roots, is_spanning, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedForests(
+        graph.get(), roots, is_spanning, search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedForests(
+        graph.get(), roots, is_spanning, search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1414,17 +1669,20 @@ static PyObject* graphset_rooted_trees(PyObject*, PyObject* args,
   static char s2[] = "root";
   static char s3[] = "is_spanning";
   static char s4[] = "search_space";
-  static char* kwlist[] = {s1, s2, s3, s4, NULL};
+  static char s5[] = "estimate";
+  static char* kwlist[] = {s1, s2, s3, s4, s5, NULL};
   PyObject* graph_obj = NULL;
   PyObject* search_space_obj = NULL;
+  PyObject* estimate_obj = NULL;
   PyObject* root_obj = NULL;
   int is_spanning = false;
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OSp|O", kwlist, &graph_obj,
-                                   &root_obj, &is_spanning, &search_space_obj))
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OSp|OO", kwlist, &graph_obj,
+                                   &root_obj, &is_spanning, &search_space_obj,
+                                   &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1443,8 +1701,20 @@ static PyObject* graphset_rooted_trees(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss =
-      digraphillion::SearchRootedTrees(graph, root, is_spanning, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateRootedTrees(
+        graph.get(), root, is_spanning, search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchRootedTrees(
+        graph.get(), root, is_spanning, search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1458,18 +1728,20 @@ static PyObject* graphset_directed_graphs(PyObject*, PyObject* args,
   static char s2[] = "in_degree_constraints";
   static char s3[] = "out_degree_constraints";
   static char s4[] = "search_space";
-  static char* kwlist[] = {s1, s2, s3, s4, NULL};
+  static char s5[] = "estimate";
+  static char* kwlist[] = {s1, s2, s3, s4, s5, NULL};
   PyObject* graph_obj = NULL;
   PyObject* in_degree_constraints_obj = NULL;
   PyObject* out_degree_constraints_obj = NULL;
   PyObject* search_space_obj = NULL;
+  PyObject* estimate_obj = NULL;
   if (!PyArg_ParseTupleAndKeywords(
-          args, kwds, "O|OOO", kwlist, &graph_obj, &in_degree_constraints_obj,
-          &out_degree_constraints_obj, &search_space_obj))
+          args, kwds, "O|OOOO", kwlist, &graph_obj, &in_degree_constraints_obj,
+          &out_degree_constraints_obj, &search_space_obj, &estimate_obj))
     return NULL;
 
-  std::vector<std::pair<std::string, std::string> > graph;
-  if (!input_graph(graph_obj, graph)) {
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
     return NULL;
   }
 
@@ -1499,8 +1771,22 @@ static PyObject* graphset_directed_graphs(PyObject*, PyObject* args,
   if (search_space_obj != NULL && search_space_obj != Py_None)
     search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
 
-  digraphillion::setset ss = digraphillion::SearchDirectedGraphs(
-      graph, in_degree_constraints, out_degree_constrains, search_space);
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedGraphs(
+        graph.get(), in_degree_constraints, out_degree_constrains,
+        search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedGraphs(
+        graph.get(), in_degree_constraints, out_degree_constrains,
+        search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
 
   PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
       PySetset_Type.tp_alloc(&PySetset_Type, 0));
@@ -1508,6 +1794,232 @@ static PyObject* graphset_directed_graphs(PyObject*, PyObject* args,
   return reinterpret_cast<PyObject*>(ret);
 }
 
+// structure_obj is None or the name of the search method of DiGraphSet
+// giving the structure of the subgraphs.
+bool input_structure(PyObject* structure_obj,
+                     digraphillion::SubgraphQuery::Structure* structure) {
+  *structure = digraphillion::SubgraphQuery::ANY;
+  if (structure_obj == NULL || structure_obj == Py_None) return true;
+  if (!PyStr_Check(structure_obj)) {
+    PyErr_SetString(PyExc_TypeError, "invalid structure");
+    return false;
+  }
+  const std::string s = PyString_AsString(structure_obj);
+  if (s == "directed_cycles") {
+    *structure = digraphillion::SubgraphQuery::CYCLE;
+  } else if (s == "directed_hamiltonian_cycles") {
+    *structure = digraphillion::SubgraphQuery::HAMILTONIAN_CYCLE;
+  } else if (s == "directed_st_paths") {
+    *structure = digraphillion::SubgraphQuery::ST_PATH;
+  } else if (s == "rooted_forests") {
+    *structure = digraphillion::SubgraphQuery::FOREST;
+  } else if (s == "rooted_trees") {
+    *structure = digraphillion::SubgraphQuery::ROOTED_TREE;
+  } else {
+    PyErr_SetString(PyExc_ValueError, "invalid structure");
+    return false;
+  }
+  return true;
+}
+
+bool input_vertex(PyObject* vertex_obj, const char* name,
+                  std::string& vertex) {
+  if (vertex_obj == NULL || vertex_obj == Py_None) {
+    PyErr_Format(PyExc_TypeError, "no vertex %s", name);
+    return false;
+  }
+  if (!PyBytes_Check(vertex_obj)) {
+    PyErr_Format(PyExc_TypeError, "invalid vertex %s", name);
+    return false;
+  }
+  vertex = PyBytes_AsString(vertex_obj);
+  return true;
+}
+
+static PyObject* graphset_directed_subgraphs(PyObject*, PyObject* args,
+                                             PyObject* kwds) {
+  static char s1[] = "graph";
+  static char s2[] = "structure";
+  static char s3[] = "s";
+  static char s4[] = "t";
+  static char s5[] = "is_hamiltonian";
+  static char s6[] = "roots";
+  static char s7[] = "root";
+  static char s8[] = "is_spanning";
+  static char s9[] = "in_degree_constraints";
+  static char s10[] = "out_degree_constraints";
+  static char s11[] = "num_edges";
+  static char s12[] = "search_space";
+  static char s13[] = "estimate";
+  static char* kwlist[] = {s1, s2,  s3,  s4,  s5,  s6,  s7,
+                           s8, s9, s10, s11, s12, s13, NULL};
+  PyObject* graph_obj = NULL;
+  PyObject* structure_obj = NULL;
+  PyObject* s_obj = NULL;
+  PyObject* t_obj = NULL;
+  int is_hamiltonian = false;
+  PyObject* roots_obj = NULL;
+  PyObject* root_obj = NULL;
+  int is_spanning = false;
+  PyObject* in_degree_constraints_obj = NULL;
+  PyObject* out_degree_constraints_obj = NULL;
+  PyObject* num_edges_obj = NULL;
+  PyObject* search_space_obj = NULL;
+  PyObject* estimate_obj = NULL;
+  if (!PyArg_ParseTupleAndKeywords(
+          args, kwds, "O|OOOpOOpOOOOO", kwlist, &graph_obj, &structure_obj,
+          &s_obj, &t_obj, &is_hamiltonian, &roots_obj, &root_obj,
+          &is_spanning, &in_degree_constraints_obj,
+          &out_degree_constraints_obj, &num_edges_obj, &search_space_obj,
+          &estimate_obj))
+    return NULL;
+
+  GraphHandle graph;
+  if (!graph.input(graph_obj)) {
+    return NULL;
+  }
+
+  digraphillion::SubgraphQuery query;
+  if (!input_structure(structure_obj, &query.structure)) return NULL;
+  query.is_hamiltonian = is_hamiltonian;
+  query.is_spanning = is_spanning;
+  if (query.structure == digraphillion::SubgraphQuery::ST_PATH) {
+    if (!input_vertex(s_obj, "s", query.s)) return NULL;
+    if (!input_vertex(t_obj, "t", query.t)) return NULL;
+  }
+  if (query.structure == digraphillion::SubgraphQuery::ROOTED_TREE) {
+    if (!input_vertex(root_obj, "root", query.root)) return NULL;
+  }
+  if (query.structure == digraphillion::SubgraphQuery::FOREST &&
+      roots_obj != NULL && roots_obj != Py_None) {
+    if (!input_string_list(roots_obj, query.roots)) return NULL;
+  }
+
+  std::map<std::string, tdzdd::Range> in_degree_constraints;
+  if (in_degree_constraints_obj != NULL &&
+      in_degree_constraints_obj != Py_None) {
+    query.in_degree_constraints = &in_degree_constraints;
+    if (!input_vertex_to_range_map(in_degree_constraints_obj,
+                                   in_degree_constraints)) {
+      return NULL;
+    }
+  }
+
+  std::map<std::string, tdzdd::Range> out_degree_constraints;
+  if (out_degree_constraints_obj != NULL &&
+      out_degree_constraints_obj != Py_None) {
+    query.out_degree_constraints = &out_degree_constraints;
+    if (!input_vertex_to_range_map(out_degree_constraints_obj,
+                                   out_degree_constraints)) {
+      return NULL;
+    }
+  }
+
+  tdzdd::Range num_edges;
+  if (num_edges_obj != NULL && num_edges_obj != Py_None) {
+    int lower, upper, step;
+    if (!PyArg_ParseTuple(num_edges_obj, "iii", &lower, &upper, &step))
+      return NULL;
+    if (lower >= upper || step <= 0) {
+      PyErr_SetString(PyExc_ValueError, "invalid number of edges");
+      return NULL;
+    }
+    num_edges = tdzdd::Range(lower, upper, step);
+    query.num_edges = &num_edges;
+  }
+
+  digraphillion::setset* search_space = NULL;
+  if (search_space_obj != NULL && search_space_obj != Py_None)
+    search_space = reinterpret_cast<PySetsetObject*>(search_space_obj)->ss;
+
+  int width_limit;
+  if (!input_width_limit(estimate_obj, &width_limit)) return NULL;
+  if (width_limit > 0) {
+    return build_estimate(digraphillion::EstimateDirectedSubgraphs(
+        graph.get(), query, search_space, width_limit));
+  }
+
+  digraphillion::setset ss;
+  try {
+    ss = digraphillion::SearchDirectedSubgraphs(graph.get(), query,
+                                                search_space);
+  } catch (std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
+
+  PySetsetObject* ret = reinterpret_cast<PySetsetObject*>(
+      PySetset_Type.tp_alloc(&PySetset_Type, 0));
+  ret->ss = new digraphillion::setset(ss);
+  return reinterpret_cast<PyObject*>(ret);
+}
+
+static PyObject* graphset_register_universe_graph(PyObject*,
+                                                  PyObject* graph_obj) {
+  std::vector<std::pair<std::string, std::string> > graph;
+  if (!input_graph(graph_obj, graph)) {
+    return NULL;
+  }
+  return PyInt_FromLong(digraphillion::RegisterUniverseGraph(graph));
+}
+
+bool input_indexed_edges(PyObject* edges_obj, int num_vertices,
+                         std::vector<digraphillion::indexed_edge_t>& edges) {
+  PyObject* i = PyObject_GetIter(edges_obj);
+  if (i == NULL) return false;
+  PyObject* eo;
+  while ((eo = PyIter_Next(i))) {
+    int u, v;
+    if (!PyArg_ParseTuple(eo, "ii", &u, &v)) {
+      Py_DECREF(eo);
+      Py_DECREF(i);
+      return false;
+    }
+    Py_DECREF(eo);
+    if (u < 0 || u >= num_vertices || v < 0 || v >= num_vertices) {
+      Py_DECREF(i);
+      PyErr_SetString(PyExc_ValueError, "invalid vertex in the edges");
+      return false;
+    }
+    edges.push_back(std::make_pair(u, v));
+  }
+  Py_DECREF(i);
+  return !PyErr_Occurred();
+}
+
+static PyObject* graphset_order_edges(PyObject*, PyObject* args) {
+  int num_vertices;
+  PyObject* edges_obj;
+  int source = -1;
+  if (!PyArg_ParseTuple(args, "iO|i", &num_vertices, &edges_obj, &source))
+    return NULL;
+  std::vector<digraphillion::indexed_edge_t> edges;
+  if (!input_indexed_edges(edges_obj, num_vertices, edges)) return NULL;
+  if (source >= num_vertices) {
+    PyErr_SetString(PyExc_ValueError, "invalid source");
+    return NULL;
+  }
+  std::vector<int> order =
+      digraphillion::OrderEdgesByFrontier(num_vertices, edges, source);
+  PyObject* lo = PyList_New(order.size());
+  if (lo == NULL) return NULL;
+  for (size_t j = 0; j < order.size(); ++j) {
+    PyList_SET_ITEM(lo, j, PyInt_FromLong(order[j]));
+  }
+  return lo;
+}
+
+static PyObject* graphset_frontier_widths(PyObject*, PyObject* args) {
+  int num_vertices;
+  PyObject* edges_obj;
+  if (!PyArg_ParseTuple(args, "iO", &num_vertices, &edges_obj)) return NULL;
+  std::vector<digraphillion::indexed_edge_t> edges;
+  if (!input_indexed_edges(edges_obj, num_vertices, edges)) return NULL;
+  digraphillion::FrontierWidths widths =
+      digraphillion::ComputeFrontierWidths(num_vertices, edges);
+  return Py_BuildValue("(iL)", widths.max,
+                       static_cast<long long>(widths.total));
+}
+
 static PyObject* graphset_show_messages(PySetsetObject* self, PyObject* obj) {
   int ret = digraphillion::ShowMessages(PyObject_IsTrue(obj));
   if (ret)
@@ -1516,12 +2028,32 @@ static PyObject* graphset_show_messages(PySetsetObject* self, PyObject* obj) {
     Py_RETURN_FALSE;
 }
 
+static PyObject* graphset_num_threads(PyObject*, PyObject* args) {
+  PyObject* obj = NULL;
+  if (!PyArg_ParseTuple(args, "|O", &obj)) return NULL;
+  if (obj == NULL) {
+    return PyInt_FromLong(digraphillion::NumThreads());
+  } else {
+    CHECK_OR_ERROR(obj, PyInt_Check, "int", NULL);
+    long num_threads = PyInt_AsLong(obj);
+    if (num_threads == -1 && PyErr_Occurred()) return NULL;
+    if (num_threads <= 0 || num_threads > INT_MAX) {
+      PyErr_SetString(PyExc_ValueError, "number of threads must be positive");
+      return NULL;
+    }
+    return PyInt_FromLong(
+        digraphillion::SetNumThreads(static_cast<int>(num_threads)));
+  }
+}
+
 static PyMethodDef module_methods[] = {
     {"load", reinterpret_cast<PyCFunction>(setset_load), METH_O, ""},
     {"loads", reinterpret_cast<PyCFunction>(setset_loads), METH_O, ""},
     {"_elem_limit", reinterpret_cast<PyCFunction>(setset_elem_limit),
      METH_NOARGS, ""},
     {"_num_elems", setset_num_elems, METH_VARARGS, ""},
+    {"_register_universe_graph", graphset_register_universe_graph, METH_O,
+     ""},
     {"_directed_cycles",
      reinterpret_cast<PyCFunction>(graphset_directed_cycles),
      METH_VARARGS | METH_KEYWORDS, ""},
@@ -1538,8 +2070,14 @@ static PyMethodDef module_methods[] = {
     {"_directed_graphs",
      reinterpret_cast<PyCFunction>(graphset_directed_graphs),
      METH_VARARGS | METH_KEYWORDS, ""},
+    {"_directed_subgraphs",
+     reinterpret_cast<PyCFunction>(graphset_directed_subgraphs),
+     METH_VARARGS | METH_KEYWORDS, ""},
     {"_show_messages", reinterpret_cast<PyCFunction>(graphset_show_messages),
      METH_O, ""},
+    {"_num_threads", graphset_num_threads, METH_VARARGS, ""},
+    {"_order_edges", graphset_order_edges, METH_VARARGS, ""},
+    {"_frontier_widths", graphset_frontier_widths, METH_VARARGS, ""},
     {NULL} /* Sentinel */
 };
 
@@ -27,6 +27,7 @@
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 #include "dd/DdBuilder.hpp"
 #include "dd/DepthFirstSearcher.hpp"
@@ -52,6 +53,13 @@ namespace tdzdd {
  *
  * Optionally, the following functions can be overloaded:
  * - void printLevel(std::ostream& os, int level) const
+ * - int datasize_at_level(int level) const
+ * - void get_copy_at_level(void* to, void const* from, int level)
+ *
+ * datasize_at_level(int) returns the size of the states stored at the level,
+ * which must not exceed datasize(); get_copy_at_level(void*, void const*, int)
+ * copies a state of the level. Builders may allocate only that size for the
+ * nodes at the level, while working storage is always datasize() large.
  *
  * A return code of get_root(void*) or get_child(void*, int, bool) is:
  * 0 when the node is the 0-terminal, -1 when it is the 1-terminal, or
@@ -81,6 +89,14 @@ public:
         os << level;
     }
 
+    int datasize_at_level(int level) const {
+        return entity().datasize();
+    }
+
+    void get_copy_at_level(void* to, void const* from, int level) {
+        entity().get_copy(to, from);
+    }
+
     /**
      * Returns a random instance using simple depth-first search
      * without caching.
@@ -351,6 +367,11 @@ public:
  * Abstract class of DD specifications using POD array states.
  * The size of array must be set by setArraySize(int n) in the constructor
  * and cannot be changed.
+ * The sizes of the arrays stored at each level can additionally be narrowed
+ * by setLevelArraySizes(std::vector<int> const& sizes) in the constructor.
+ * Array elements beyond the size at a level are zero-cleared before
+ * getChild(T*, int, int) is called at the level and are ignored in hashing
+ * and comparison.
  * If you want some arbitrary-sized data storage for states,
  * use pointers to those storages in DdSpec instead.
  *
@@ -379,6 +400,36 @@ private:
 
     int arraySize;
     int dataWords;
+    std::vector<int> levelWords;
+
+    static int numWords(int n) {
+        return (n * sizeof(State) + sizeof(Word) - 1) / sizeof(Word);
+    }
+
+    int dataWordsAtLevel(int level) const {
+        return levelWords.empty() ? dataWords : levelWords[level];
+    }
+
+    static size_t hashWords(State const* s, int n) {
+        Word const* pa = reinterpret_cast<Word const*>(s);
+        Word const* pz = pa + n;
+        size_t h = 0;
+        while (pa != pz) {
+            h += *pa++;
+            h *= 314159257;
+        }
+        return h;
+    }
+
+    static bool equalWords(State const* s1, State const* s2, int n) {
+        Word const* pa = reinterpret_cast<Word const*>(s1);
+        Word const* qa = reinterpret_cast<Word const*>(s2);
+        Word const* pz = pa + n;
+        while (pa != pz) {
+            if (*pa++ != *qa++) return false;
+        }
+        return true;
+    }
 
     static State* state(void* p) {
         return static_cast<State*>(p);
@@ -395,7 +446,23 @@ protected:
             throw std::runtime_error(
                     "Cannot set array size twice; use setArraySize(int) only once in the constructor of DD spec.");
         arraySize = n;
-        dataWords = (n * sizeof(State) + sizeof(Word) - 1) / sizeof(Word);
+        dataWords = numWords(n);
+    }
+
+    /**
+     * Sets the array size of the states at each level.
+     * @param sizes array sizes indexed by level, none of which exceeds
+     * the size given by setArraySize(int).
+     */
+    void setLevelArraySizes(std::vector<int> const& sizes) {
+        if (arraySize < 0)
+            throw std::runtime_error(
+                    "Array size is unknown; use setArraySize(int) before setLevelArraySizes(std::vector<int> const&).");
+        levelWords.resize(sizes.size());
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            assert(0 <= sizes[i] && sizes[i] <= arraySize);
+            levelWords[i] = numWords(sizes[i]);
+        }
     }
 
     int getArraySize() const {
@@ -414,12 +481,23 @@ public:
         return dataWords * sizeof(Word);
     }
 
+    int datasize_at_level(int level) const {
+        return dataWordsAtLevel(level) * sizeof(Word);
+    }
+
     int get_root(void* p) {
         return this->entity().getRoot(state(p));
     }
 
     int get_child(void* p, int level, int value) {
         assert(0 <= value && value < S::ARITY);
+        if (!levelWords.empty()) {
+            Word* pa = static_cast<Word*>(p) + levelWords[level];
+            Word* pz = static_cast<Word*>(p) + dataWords;
+            while (pa != pz) {
+                *pa++ = 0;
+            }
+        }
         return this->entity().getChild(state(p), level, value);
     }
 
@@ -432,6 +510,15 @@ public:
         }
     }
 
+    void get_copy_at_level(void* to, void const* from, int level) {
+        Word const* pa = static_cast<Word const*>(from);
+        Word const* pz = pa + dataWordsAtLevel(level);
+        Word* qa = static_cast<Word*>(to);
+        while (pa != pz) {
+            *qa++ = *pa++;
+        }
+    }
+
     int mergeStates(T* a1, T* a2) {
         return 0;
     }
@@ -447,17 +534,11 @@ public:
     }
 
     size_t hashCode(State const* s) const {
-        Word const* pa = reinterpret_cast<Word const*>(s);
-        Word const* pz = pa + dataWords;
-        size_t h = 0;
-        while (pa != pz) {
-            h += *pa++;
-            h *= 314159257;
-        }
-        return h;
+        return hashWords(s, dataWords);
     }
 
     size_t hashCodeAtLevel(State const* s, int level) const {
+        if (!levelWords.empty()) return hashWords(s, levelWords[level]);
         return this->entity().hashCode(s);
     }
 
@@ -466,16 +547,11 @@ public:
     }
 
     bool equalTo(State const* s1, State const* s2) const {
-        Word const* pa = reinterpret_cast<Word const*>(s1);
-        Word const* qa = reinterpret_cast<Word const*>(s2);
-        Word const* pz = pa + dataWords;
-        while (pa != pz) {
-            if (*pa++ != *qa++) return false;
-        }
-        return true;
+        return equalWords(s1, s2, dataWords);
     }
 
     bool equalToAtLevel(State const* s1, State const* s2, int level) const {
+        if (!levelWords.empty()) return equalWords(s1, s2, levelWords[level]);
         return this->entity().equalTo(s1, s2);
     }
 
@@ -45,6 +45,7 @@
 #include "util/MessageHandler.hpp"
 #include "util/MyHashTable.hpp"
 #include "util/MyVector.hpp"
+#include "util/Threads.hpp"
 
 namespace tdzdd {
 
@@ -142,7 +143,7 @@ private:
 
         if (n > 0) {
 #ifdef _OPENMP
-            mh << " " << omp_get_max_threads() << "x";
+            mh << " " << maxThreads() << "x";
 #endif
             mh.setSteps(n);
             for (int i = n; i > 0; --i) {
@@ -206,7 +207,7 @@ private:
 
         if (n > 0) {
 #ifdef _OPENMP
-            mh << " " << omp_get_max_threads() << "x";
+            mh << " " << maxThreads() << "x";
 #endif
             mh.setSteps(n);
             for (int i = n; i > 0; --i) {
@@ -393,7 +394,7 @@ public:
         int n = root_.row();
 
 #ifdef _OPENMP
-        if (useMP) mh << " " << omp_get_max_threads() << "x";
+        if (useMP) mh << " " << maxThreads() << "x";
 #endif
 
         DdReducer<ARITY,BDD,ZDD> zr(diagram, useMP);
@@ -464,19 +465,19 @@ public:
         if (msg) {
             mh.begin(typenameof(eval));
 #ifdef _OPENMP
-            if (useMP) mh << " " << omp_get_max_threads() << "x";
+            if (useMP) mh << " " << maxThreads() << "x";
 #endif
             mh.setSteps(n);
         }
 
 #ifdef _OPENMP
-        int threads = useMP ? omp_get_max_threads() : 0;
+        int threads = useMP ? maxThreads() : 0;
         MyVector<S> evals(threads, eval);
 #endif
         eval.initialize(n);
 #ifdef _OPENMP
         if (useMP)
-#pragma omp parallel
+#pragma omp parallel num_threads(maxThreads())
         {
             int k = omp_get_thread_num();
             evals[k].initialize(n);
@@ -500,7 +501,7 @@ public:
 
 #ifdef _OPENMP
             if (useMP)
-#pragma omp parallel
+#pragma omp parallel num_threads(maxThreads())
             {
                 int k = omp_get_thread_num();
 
@@ -534,7 +535,7 @@ public:
             }
 #ifdef _OPENMP
             if (useMP)
-#pragma omp parallel
+#pragma omp parallel num_threads(maxThreads())
             {
                 int k = omp_get_thread_num();
                 for (int const* t = levels.begin(); t != levels.end(); ++t) {
@@ -42,6 +42,7 @@
 #include "../util/MyHashTable.hpp"
 #include "../util/MyList.hpp"
 #include "../util/MyVector.hpp"
+#include "../util/Threads.hpp"
 
 namespace tdzdd {
 
@@ -425,7 +426,7 @@ class DdBuilderMP: DdBuilderMPBase {//TODO oneStorage
 public:
     DdBuilderMP(Spec const& s, NodeTableHandler<AR>& output, int n = 0) :
 #ifdef _OPENMP
-            threads(omp_get_max_threads()),
+            threads(maxThreads()),
             tasks(MyHashConstant::primeSize(TASKS_PER_THREAD * threads)),
 #else
             threads(1),
@@ -505,7 +506,7 @@ public:
 
 #ifdef _OPENMP
         // OpenMP 2.0 does not support reduction(min:lowestChild)
-#pragma omp parallel reduction(+:deadCount)
+#pragma omp parallel reduction(+:deadCount) num_threads(maxThreads())
 #endif
         {
 #ifdef _OPENMP
@@ -682,7 +683,7 @@ class ZddSubsetter: DdBuilderBase {
     static int const AR = Spec::ARITY;
 
     Spec spec;
-    int const specNodeSize;
+    MyVector<int> specNodeSize; // indexed by level
     NodeTableEntity<AR> const& input;
     NodeTableEntity<AR>& output;
     DataTable<MyListOnPool<SpecNode> > work;
@@ -698,7 +699,6 @@ public:
     ZddSubsetter(NodeTableHandler<AR> const& input, Spec const& s,
                  NodeTableHandler<AR>& output) :
             spec(s),
-            specNodeSize(getSpecNodeSize(spec.datasize())),
             input(*input),
             output(output.privateEntity()),
             work(input->numRows()),
@@ -748,10 +748,14 @@ public:
 
             pools.resize(n + 1);
             work[n].resize(input[n].size());
+            specNodeSize.resize(n + 1);
+            for (int i = 0; i <= n; ++i) {
+                specNodeSize[i] = getSpecNodeSize(spec.datasize_at_level(i));
+            }
 
             SpecNode* p0 = work[n][root.col()].alloc_front(pools[n],
-                    specNodeSize);
-            spec.get_copy(state(p0), tmpState);
+                    specNodeSize[n]);
+            spec.get_copy_at_level(state(p0), tmpState, n);
             srcPtr(p0) = &root;
         }
 
@@ -849,7 +853,7 @@ public:
                     }
 
                     NodeId f(i, j);
-                    spec.get_copy(tmpState, state(p));
+                    spec.get_copy_at_level(tmpState, state(p), i);
                     int kk = downTable(f, b, i - 1);
                     int ii = downSpec(tmpState, i, b, kk);
 
@@ -906,8 +910,8 @@ public:
                         assert(ii == f.row() && ii == kk && ii < i);
                         if (work[ii].empty()) work[ii].resize(input[ii].size());
                         SpecNode* pp = work[ii][f.col()].alloc_front(pools[ii],
-                                specNodeSize);
-                        spec.get_copy(state(pp), tmpState);
+                                specNodeSize[ii]);
+                        spec.get_copy_at_level(state(pp), tmpState, ii);
                         srcPtr(pp) = &q.branch[b];
                         if (ii < lowestChild) lowestChild = ii;
                         allZero = false;
@@ -964,7 +968,7 @@ class ZddSubsetterMP: DdBuilderMPBase { //TODO oneStorage
     int const threads;
 
     MyVector<Spec> specs;
-    int const specNodeSize;
+    MyVector<int> specNodeSize; // indexed by level
     NodeTableEntity<AR> const& input;
     NodeTableEntity<AR>& output;
     DdSweeper<AR> sweeper;
@@ -977,13 +981,12 @@ public:
                    Spec const& s,
                    NodeTableHandler<AR>& output) :
 #ifdef _OPENMP
-            threads(omp_get_max_threads()),
+            threads(maxThreads()),
 
 #else
             threads(1),
 #endif
             specs(threads, s),
-            specNodeSize(getSpecNodeSize(s.datasize())),
             input(*input),
             output(output.privateEntity()),
             sweeper(this->output),
@@ -1028,11 +1031,15 @@ public:
                 snodeTables[y].resize(n + 1);
                 pools[y].resize(n + 1);
             }
+            specNodeSize.resize(n + 1);
+            for (int i = 0; i <= n; ++i) {
+                specNodeSize[i] = getSpecNodeSize(spec.datasize_at_level(i));
+            }
 
             snodeTables[0][n].resize(input[n].size());
             SpecNode* p0 = snodeTables[0][n][root.col()].alloc_front(
-                    pools[0][n], specNodeSize);
-            spec.get_copy(state(p0), tmpState);
+                    pools[0][n], specNodeSize[n]);
+            spec.get_copy_at_level(state(p0), tmpState, n);
             srcPtr(p0) = &root;
         }
 
@@ -1055,7 +1062,7 @@ public:
 
 #ifdef _OPENMP
         // OpenMP 2.0 does not support reduction(min:lowestChild)
-#pragma omp parallel reduction(+:deadCount)
+#pragma omp parallel reduction(+:deadCount) num_threads(maxThreads())
 #endif
         {
 #ifdef _OPENMP
@@ -1069,6 +1076,9 @@ public:
             Hasher<Spec> hasher(spec, i);
             UniqTable uniq(hasher, hasher);
             int lc = lowestChild;
+            // A node narrower than the working storage cannot be
+            // used as the working storage of its last child.
+            bool const inPlace = spec.datasize_at_level(i) == spec.datasize();
 
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
@@ -1151,8 +1161,8 @@ public:
                         void* s = tmpState;
 
                         for (int b = 0; b < AR; ++b) {
-                            if (b < AR - 1) {
-                                spec.get_copy(s, state(p));
+                            if (b < AR - 1 || !inPlace) {
+                                spec.get_copy_at_level(s, state(p), i);
                             }
                             else {
                                 s = state(p);
@@ -1189,8 +1199,8 @@ public:
 
                                 SpecNode* pp =
                                         snodeTables[yy][ii][jj].alloc_front(
-                                                pools[yy][ii], specNodeSize);
-                                spec.get_copy(state(pp), s);
+                                                pools[yy][ii], specNodeSize[ii]);
+                                spec.get_copy_at_level(state(pp), s, ii);
                                 srcPtr(pp) = &q.branch[b];
                                 if (ii < lc) lc = ii;
                                 allZero = false;
@@ -1199,6 +1209,7 @@ public:
                             spec.destruct(s);
                         }
 
+                        if (!inPlace) spec.destruct(state(p));
                         if (allZero) ++deadCount;
                     }
                 }
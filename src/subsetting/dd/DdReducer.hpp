@@ -38,6 +38,7 @@
 #include "../util/MyHashTable.hpp"
 #include "../util/MyList.hpp"
 #include "../util/MyVector.hpp"
+#include "../util/Threads.hpp"
 
 namespace tdzdd {
 
@@ -92,7 +93,7 @@ public:
             newIdTable(input.numRows()),
             rootPtr(input.numRows()),
 #ifdef _OPENMP
-            threads(omp_get_max_threads()),
+            threads(maxThreads()),
             tasks(MyHashConstant::primeSize(TASKS_PER_THREAD * threads)),
             taskMatrix(threads),
             baseColumn(tasks + 1),
@@ -416,7 +417,7 @@ private:
         etcP1.start();
 #endif
 
-#pragma omp parallel
+#pragma omp parallel num_threads(maxThreads())
         {
             int y = omp_get_thread_num();
             MyHashTable<ReducNodeInfo const*> uniq;
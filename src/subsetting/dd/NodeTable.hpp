@@ -33,6 +33,7 @@
 #include "Node.hpp"
 #include "DataTable.hpp"
 #include "../util/MyVector.hpp"
+#include "../util/Threads.hpp"
 
 namespace tdzdd {
 
@@ -264,7 +265,7 @@ public:
 
 #ifdef _OPENMP
             if (useMP) {
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) num_threads(maxThreads())
                 for (intmax_t j = 0; j < intmax_t(m); ++j) {
                     for (int b = 0; b < ARITY; ++b) {
                         int const ii = node[j].branch[b].row();
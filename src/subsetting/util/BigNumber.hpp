@@ -31,6 +31,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace tdzdd {
 
@@ -262,6 +263,77 @@ public:
     }
 };
 
+/**
+ * Unsigned integers packed in full 64-bit words from the least significant
+ * one, whose width is fixed by the caller.  Unlike BigNumber, no word has
+ * a continuation flag, so numbers of the same width are laid out in flat
+ * arrays and added by straight loops over the words.
+ */
+class PackedBigNumber {
+public:
+    /**
+     * Returns the number of the words for numbers less than 2^bits.
+     */
+    static int words(int bits) {
+        return bits / 64 + 1;
+    }
+
+    static void clear(uint64_t* p, int w) {
+        for (int i = 0; i < w; ++i) {
+            p[i] = 0;
+        }
+    }
+
+    /**
+     * Adds the number of @p qw words to the number of @p pw words,
+     * where qw <= pw and the sum must fit in pw words.
+     */
+    static void add(uint64_t* p, int pw, uint64_t const* q, int qw) {
+        assert(qw <= pw);
+        uint64_t carry = 0;
+        for (int i = 0; i < qw; ++i) {
+            uint64_t x = p[i] + carry;
+            carry = x < carry;
+            x += q[i];
+            carry += x < q[i];
+            p[i] = x;
+        }
+        for (int i = qw; carry != 0 && i < pw; ++i) {
+            carry = ++p[i] == 0;
+        }
+        assert(carry == 0);
+    }
+
+    static std::string toString(uint64_t const* p, int w) {
+        // 32-bit digits from the most significant one, which are divided
+        // by 10^9 repeatedly
+        std::vector<uint64_t> d(w * 2);
+        for (int i = 0; i < w; ++i) {
+            d[w * 2 - 1 - i * 2] = p[i] & 0xFFFFFFFFU;
+            d[w * 2 - 2 - i * 2] = p[i] >> 32;
+        }
+        size_t top = 0;
+        std::string s;
+        do {
+            uint64_t r = 0;
+            for (size_t i = top; i < d.size(); ++i) {
+                r = (r << 32) | d[i];
+                d[i] = r / 1000000000U;
+                r %= 1000000000U;
+            }
+            while (top < d.size() && d[top] == 0) {
+                ++top;
+            }
+            for (int k = 0; k < 9 && (top < d.size() || r != 0); ++k) {
+                s += char('0' + r % 10);
+                r /= 10;
+            }
+        } while (top < d.size());
+        if (s.empty()) s = "0";
+        return std::string(s.rbegin(), s.rend());
+    }
+};
+
 template<int size>
 class FixedBigNumber {
     uint32_t val[size];
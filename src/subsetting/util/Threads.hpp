@@ -0,0 +1,55 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+namespace tdzdd {
+
+/**
+ * The number of threads for the parallel regions of TdZdd.
+ * It is given to each region by a num_threads clause, so that the OpenMP
+ * setting of the process is left to the application.
+ */
+inline int& maxThreadsRef() {
+    static int n = 1;
+    return n;
+}
+
+/**
+ * Returns the number of threads for the parallel regions of TdZdd.
+ */
+inline int maxThreads() {
+    return maxThreadsRef();
+}
+
+/**
+ * Sets the number of threads for the parallel regions of TdZdd.
+ * @param n the number of threads, which must be positive.
+ */
+inline void setMaxThreads(int n) {
+    maxThreadsRef() = n;
+}
+
+} // namespace tdzdd